@@ -1,3 +1,5 @@
 #!/bin/sh
 cc opentimeline.c -std=c11 -pedantic -arch arm64 -o ot 
 
+cc opentimeline_bench.c thmap/src/thmap.c thmap/src/murmurhash.c -Ithmap/src \
+    -std=c11 -O2 -D_DEFAULT_SOURCE -arch arm64 -o ot_bench
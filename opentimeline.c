@@ -1,2 +1,28 @@
 #include "opentimeline.h"
 
+int main(int argc, char** argv) {
+    test_opentime();
+    test_interval_set();
+    test_interval_index();
+    test_tick_time();
+    test_control_points();
+    test_knot_search();
+    test_project_curve();
+    test_inverse_curve();
+    test_uniform_spacing();
+    test_curve_pyramid();
+    test_bezier_curve();
+    test_extents();
+    test_simplify();
+    test_creation();
+    test_topology_growth();
+    test_oid_recycling();
+    test_flatten();
+    test_reflatten();
+    test_active_clips();
+    if (ot_test_failures) {
+        fprintf(stderr, "%d checks failed\n", ot_test_failures);
+        return 1;
+    }
+    return 0;
+}
@@ -28,6 +28,14 @@ typedef struct {
 } OT_TimeAffineTransform;
 const OT_TimeAffineTransform OT_TimeAffineTransform_default = { {0.f}, 1.f };
 
+// The thirteen relations of Allen's interval algebra, for a relative to b.
+// Intervals with a NaN endpoint are OT_AllenInvalid.
+typedef enum {
+    OT_AllenPrecedes, OT_AllenMeets, OT_AllenOverlaps, OT_AllenFinishedBy,
+    OT_AllenContains, OT_AllenStarts, OT_AllenEquals, OT_AllenStartedBy,
+    OT_AllenDuring, OT_AllenFinishes, OT_AllenOverlappedBy, OT_AllenMetBy,
+    OT_AllenPrecededBy, OT_AllenInvalid } OT_AllenRelation;
+
 struct OpenTimeInterfaceDetail;
 typedef struct OpenTimeInterfaceDetail OpenTimeInterfaceDetail;
 typedef struct OpenTimeInterface {
@@ -44,6 +52,10 @@ typedef struct OpenTimeInterface {
     OT_TimeInterval (*transform_interval)(OT_TimeAffineTransform*, OT_TimeInterval*);
     OT_TimeAffineTransform (*compose_transform)(OT_TimeAffineTransform*, OT_TimeAffineTransform*);
     OT_TimeAffineTransform (*invert_transform)(OT_TimeAffineTransform*);
+    void (*transform_seconds_n)(OT_TimeAffineTransform*, 
+            OT_seconds* in, OT_seconds* out, size_t count);
+    void (*transform_interval_n)(OT_TimeAffineTransform*, 
+            OT_TimeInterval* in, OT_TimeInterval* out, size_t count);
 
     // Interval Algebra
     bool (*interval_equals)(OT_TimeInterval* a, OT_TimeInterval* b);
@@ -56,6 +68,9 @@ typedef struct OpenTimeInterface {
     bool (*interval_ends)(OT_TimeInterval* a, OT_TimeInterval* b);
     bool (*interval_disjoint)(OT_TimeInterval* a, OT_TimeInterval* b);
     bool (*interval_within)(OT_TimeInterval* a, OT_TimeInterval* b);
+    OT_AllenRelation (*interval_relate)(OT_TimeInterval* a, OT_TimeInterval* b);
+    void (*interval_relate_n)(OT_TimeInterval* a, OT_TimeInterval* b, 
+            uint8_t* relations_out, size_t count);
 } OpenTimeInterface;
 
 typedef struct {
@@ -65,11 +80,204 @@ typedef struct {
 
 OpenTimeInterface* opentime_create(OpenTimeAllocator*);
 
+// batched transforms; out may alias in
+void ot_transform_seconds_n(OT_TimeAffineTransform* x,
+        OT_seconds* in, OT_seconds* out, size_t count);
+void ot_transform_interval_n(OT_TimeAffineTransform* x,
+        OT_TimeInterval* in, OT_TimeInterval* out, size_t count);
+
+// classifies a[i] against b[i], writing an OT_AllenRelation per pair
+void ot_interval_relate_n(OT_TimeInterval* a, OT_TimeInterval* b,
+        uint8_t* relations_out, size_t count);
+
+// Inline API
+//
+// The same operations as OpenTimeInterface, taking values instead of
+// pointers and without null checks, so that hot loops can be fully inlined
+// and vectorized. The vtable entries are thin wrappers over these.
+// Define OT_INLINE before including this header to change the linkage.
+#ifndef OT_INLINE
+#if defined(_MSC_VER)
+#define OT_INLINE static __forceinline
+#elif defined(__GNUC__)
+#define OT_INLINE static inline __attribute__((always_inline))
+#else
+#define OT_INLINE static inline
+#endif
+#endif
+
+OT_INLINE OT_seconds ot_inline_duration(OT_TimeInterval ival) {
+    if (!isfinite(ival.start.t) || !isfinite(ival.end.t))
+        return (OT_seconds){INFINITY};
+
+    return (OT_seconds){ ival.end.t - ival.start.t };
+}
+
+OT_INLINE OT_TimeInterval ot_inline_from_start_duration(OT_seconds start, OT_seconds duration) {
+    if (duration.t <= 0)
+        return (OT_TimeInterval){ { start.t + duration.t }, { -duration.t } };
+    return (OT_TimeInterval){ start, { start.t + duration.t } };
+}
+
+OT_INLINE OT_TimeInterval ot_inline_from_start(OT_seconds start) {
+    return (OT_TimeInterval){ start, { INFINITY } };
+}
+
+OT_INLINE OT_seconds ot_inline_transform_seconds(OT_TimeAffineTransform x, OT_seconds s) {
+    return (OT_seconds) { s.t * x.s + x.t.t };
+}
+
+OT_INLINE OT_TimeInterval ot_inline_transform_interval(OT_TimeAffineTransform x, OT_TimeInterval ti) {
+    return (OT_TimeInterval) { 
+        ot_inline_transform_seconds(x, ti.start), 
+        ot_inline_transform_seconds(x, ti.end) };
+}
+
+OT_INLINE OT_TimeAffineTransform ot_inline_compose_transform(OT_TimeAffineTransform x1,
+        OT_TimeAffineTransform x2) {
+    return (OT_TimeAffineTransform) {
+        ot_inline_transform_seconds(x1, x2.t),
+        x1.s * x2.s };
+}
+
+OT_INLINE OT_TimeAffineTransform ot_inline_invert_transform(OT_TimeAffineTransform x) {
+    return (OT_TimeAffineTransform) {
+        (OT_seconds) { -x.t.t / x.s },
+        1.f / x.s };
+}
+
+OT_INLINE bool ot_inline_interval_equals(OT_TimeInterval a, OT_TimeInterval b) {
+    return (a.start.t == b.start.t) && (a.end.t == b.end.t);
+}
+
+OT_INLINE bool ot_inline_interval_precedes(OT_TimeInterval a, OT_TimeInterval b) {
+    return (b.start.t > a.end.t);
+}
+
+OT_INLINE bool ot_inline_interval_meets(OT_TimeInterval a, OT_TimeInterval b) {
+    return (a.end.t == b.start.t);
+}
+
+OT_INLINE bool ot_inline_interval_disjoint(OT_TimeInterval a, OT_TimeInterval b) {
+    return (a.end.t < b.start.t) ||
+        (b.end.t < a.start.t);
+}
+
+OT_INLINE bool ot_inline_interval_starts(OT_TimeInterval a, OT_TimeInterval b) {
+    return (a.start.t == b.start.t) &&
+        (a.end.t < b.end.t);
+}
+
+OT_INLINE bool ot_inline_interval_ends(OT_TimeInterval a, OT_TimeInterval b) {
+    return (a.start.t > b.start.t) &&
+        (a.end.t == b.end.t);
+}
+
+OT_INLINE bool ot_inline_interval_overlaps(OT_TimeInterval a, OT_TimeInterval b) {
+    return (a.start.t < b.start.t) &&
+        (b.start.t < a.end.t) && (a.end.t < b.end.t);
+}
+
+OT_INLINE bool ot_inline_interval_starts_or_overlaps(OT_TimeInterval a, OT_TimeInterval b) {
+    return (a.start.t <= b.start.t) &&
+        (a.end.t > b.start.t);
+}
+
+OT_INLINE bool ot_inline_interval_during(OT_TimeInterval a, OT_TimeInterval b) {
+    return (a.start.t > b.start.t) &&
+        (a.end.t < b.end.t);
+}
+
+OT_INLINE bool ot_inline_interval_within(OT_TimeInterval a, OT_TimeInterval b) {
+    return (a.start.t >= b.start.t) &&
+        (a.end.t <= b.end.t) && !ot_inline_interval_equals(a, b);
+}
+
+// Allen relation classification
+//
+// Each endpoint comparison is reduced to an order code: 0 less, 1 equal,
+// 2 greater, 3 unordered (NaN). The four codes
+//
+//     a.start ? b.start, a.end ? b.end, a.end ? b.start, a.start ? b.end
+//
+// index a 256 entry table, so a classification is four compares and a load.
+// Where degenerate (zero length) intervals make relations coincide, equals
+// wins, then precedes, then meets.
+
+#define OT_ALLEN_LT 0
+#define OT_ALLEN_EQ 1
+#define OT_ALLEN_GT 2
+#define OT_ALLEN_UN 3
+
+#define OT_ALLEN_INNER(ss, ee) \
+    ((ss) == OT_ALLEN_LT ? ((ee) == OT_ALLEN_LT ? OT_AllenOverlaps : \
+                            (ee) == OT_ALLEN_EQ ? OT_AllenFinishedBy : OT_AllenContains) : \
+     (ss) == OT_ALLEN_EQ ? ((ee) == OT_ALLEN_LT ? OT_AllenStarts : \
+                            (ee) == OT_ALLEN_EQ ? OT_AllenEquals : OT_AllenStartedBy) : \
+                           ((ee) == OT_ALLEN_LT ? OT_AllenDuring : \
+                            (ee) == OT_ALLEN_EQ ? OT_AllenFinishes : OT_AllenOverlappedBy))
+
+#define OT_ALLEN_CLASSIFY(ss, ee, es, se) \
+    ((ss) == OT_ALLEN_UN || (ee) == OT_ALLEN_UN || \
+     (es) == OT_ALLEN_UN || (se) == OT_ALLEN_UN ? OT_AllenInvalid : \
+     (ss) == OT_ALLEN_EQ && (ee) == OT_ALLEN_EQ ? OT_AllenEquals : \
+     (es) == OT_ALLEN_LT ? OT_AllenPrecedes : \
+     (se) == OT_ALLEN_GT ? OT_AllenPrecededBy : \
+     (es) == OT_ALLEN_EQ ? OT_AllenMeets : \
+     (se) == OT_ALLEN_EQ ? OT_AllenMetBy : \
+     OT_ALLEN_INNER(ss, ee))
+
+#define OT_ALLEN_ROW4(ss, ee, es) \
+    OT_ALLEN_CLASSIFY(ss, ee, es, 0), OT_ALLEN_CLASSIFY(ss, ee, es, 1), \
+    OT_ALLEN_CLASSIFY(ss, ee, es, 2), OT_ALLEN_CLASSIFY(ss, ee, es, 3)
+#define OT_ALLEN_ROW16(ss, ee) \
+    OT_ALLEN_ROW4(ss, ee, 0), OT_ALLEN_ROW4(ss, ee, 1), \
+    OT_ALLEN_ROW4(ss, ee, 2), OT_ALLEN_ROW4(ss, ee, 3)
+#define OT_ALLEN_ROW64(ss) \
+    OT_ALLEN_ROW16(ss, 0), OT_ALLEN_ROW16(ss, 1), \
+    OT_ALLEN_ROW16(ss, 2), OT_ALLEN_ROW16(ss, 3)
+
+static const uint8_t OT_AllenTable[256] = {
+    OT_ALLEN_ROW64(0), OT_ALLEN_ROW64(1), OT_ALLEN_ROW64(2), OT_ALLEN_ROW64(3) };
+
+OT_INLINE int ot_inline_order(float x, float y) {
+    return (x == y) | ((x > y) << 1) | ((x != x || y != y) * OT_ALLEN_UN);
+}
+
+OT_INLINE OT_AllenRelation ot_inline_interval_relate(OT_TimeInterval a, OT_TimeInterval b) {
+    int idx = (ot_inline_order(a.start.t, b.start.t) << 6) |
+              (ot_inline_order(a.end.t, b.end.t) << 4) |
+              (ot_inline_order(a.end.t, b.start.t) << 2) |
+               ot_inline_order(a.start.t, b.end.t);
+    return (OT_AllenRelation) OT_AllenTable[idx];
+}
+
 #endif // OPENTIME_PROTO_H
 
 #define IMPL_OPENTIME
 #ifdef IMPL_OPENTIME
 
+// SIMD selection for the batched kernels. Define OT_NO_SIMD to force the
+// scalar paths.
+#ifndef OT_NO_SIMD
+#if defined(__AVX2__)
+#define OT_SIMD_AVX2
+#define OT_SIMD_SSE2
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#define OT_SIMD_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#define OT_SIMD_NEON
+#include <arm_neon.h>
+#endif
+#endif // OT_NO_SIMD
+
+// the batched kernels treat arrays of OT_seconds and OT_TimeInterval as
+// arrays of float.
+_Static_assert(sizeof(OT_seconds) == sizeof(float), "OT_seconds must be a bare float");
+_Static_assert(sizeof(OT_TimeInterval) == 2 * sizeof(float), "OT_TimeInterval must be two floats");
+
 struct OpenTimeInterfaceDetail {
     OpenTimeAllocator* alloc;
 };
@@ -85,31 +293,77 @@ OT_seconds ot_duration(OT_TimeInterval* ival) {
     if (!ival)
         return (OT_seconds){ 0.f };
 
-    if (!isfinite(ival->start.t) || !isfinite(ival->end.t))
-        return (OT_seconds){INFINITY};
-
-    return (OT_seconds){ ival->end.t - ival->start.t };
+    return ot_inline_duration(*ival);
 }
 
 OT_TimeInterval ot_from_start_duration(OT_seconds start, OT_seconds duration) {
-    if (duration.t <= 0)
-        return (OT_TimeInterval){ { start.t + duration.t }, { -duration.t } };
-    return (OT_TimeInterval){ start.t, { start.t + duration.t }};
+    return ot_inline_from_start_duration(start, duration);
 }
 
 OT_seconds ot_transform_seconds(OT_TimeAffineTransform* x, OT_seconds* s) {
     if (!x || !s)
         return (OT_seconds) { 0.f };
 
-    return (OT_seconds) { s->t * x->s + x->t.t };
+    return ot_inline_transform_seconds(*x, *s);
 }
 
 OT_TimeInterval ot_transform_interval(OT_TimeAffineTransform* x, OT_TimeInterval* ti) {
     if (!x || !ti)
         return OT_TimeInterval_default;
 
-    return (OT_TimeInterval) { 
-        ot_transform_seconds(x, &ti->start), ot_transform_seconds(x, &ti->end) };
+    return ot_inline_transform_interval(*x, *ti);
+}
+
+// Transforms count seconds from in to out. The multiply and add are kept
+// separate in every path so the results match ot_transform_seconds exactly.
+void ot_transform_seconds_n(OT_TimeAffineTransform* x,
+        OT_seconds* in, OT_seconds* out, size_t count) {
+    if (!x || !in || !out)
+        return;
+
+    const float* src = &in->t;
+    float* dst = &out->t;
+    const float s = x->s;
+    const float o = x->t.t;
+    size_t i = 0;
+
+#if defined(OT_SIMD_AVX2)
+    const __m256 s8 = _mm256_set1_ps(s);
+    const __m256 o8 = _mm256_set1_ps(o);
+    for (; i + 8 <= count; i += 8) {
+        __m256 v = _mm256_loadu_ps(src + i);
+        _mm256_storeu_ps(dst + i, _mm256_add_ps(_mm256_mul_ps(v, s8), o8));
+    }
+#endif
+#if defined(OT_SIMD_SSE2)
+    const __m128 s4 = _mm_set1_ps(s);
+    const __m128 o4 = _mm_set1_ps(o);
+    for (; i + 4 <= count; i += 4) {
+        __m128 v = _mm_loadu_ps(src + i);
+        _mm_storeu_ps(dst + i, _mm_add_ps(_mm_mul_ps(v, s4), o4));
+    }
+#elif defined(OT_SIMD_NEON)
+    const float32x4_t s4 = vdupq_n_f32(s);
+    const float32x4_t o4 = vdupq_n_f32(o);
+    for (; i + 4 <= count; i += 4) {
+        float32x4_t v = vld1q_f32(src + i);
+        vst1q_f32(dst + i, vaddq_f32(vmulq_f32(v, s4), o4));
+    }
+#endif
+    for (; i < count; ++i)
+        dst[i] = src[i] * s + o;
+}
+
+// Transforms count intervals from in to out. Like ot_transform_interval, a
+// negative scale is not reordered.
+void ot_transform_interval_n(OT_TimeAffineTransform* x,
+        OT_TimeInterval* in, OT_TimeInterval* out, size_t count) {
+    if (!x || !in || !out)
+        return;
+
+    // both endpoints take the same transform, so an interval array is just
+    // a seconds array of twice the length.
+    ot_transform_seconds_n(x, &in->start, &out->start, count * 2);
 }
 
 OT_TimeAffineTransform ot_compose_transform(OT_TimeAffineTransform* x1,
@@ -117,97 +371,166 @@ OT_TimeAffineTransform ot_compose_transform(OT_TimeAffineTransform* x1,
     if (!x1 || !x2)
         return OT_TimeAffineTransform_default;
 
-    return (OT_TimeAffineTransform) {
-        ot_transform_seconds(x1, &x2->t),
-        x1->s * x2->s };
+    return ot_inline_compose_transform(*x1, *x2);
 }
 
 OT_TimeAffineTransform ot_invert_transform(OT_TimeAffineTransform* x) {
-    return (OT_TimeAffineTransform) {
-        (OT_seconds) { -x->t.t / x->s },
-        1.f / x->s };
+    return ot_inline_invert_transform(*x);
 }
- 
+
 bool ot_interval_equals(OT_TimeInterval* a, OT_TimeInterval* b) {
     if (!a || !b)
         return false;
 
-    return (a->start.t == b->start.t) && (a->end.t == b->end.t);
+    return ot_inline_interval_equals(*a, *b);
 }
 
 bool ot_interval_precedes(OT_TimeInterval* a, OT_TimeInterval* b) {
     if (!a || !b)
         return false;
 
-    return (b->start.t > a->end.t);
+    return ot_inline_interval_precedes(*a, *b);
 }
 
 bool ot_interval_meets(OT_TimeInterval* a, OT_TimeInterval* b) {
     if (!a || !b)
         return false;
 
-    return (a->end.t == b->start.t);
+    return ot_inline_interval_meets(*a, *b);
 }
 
 bool ot_interval_disjoint(OT_TimeInterval* a, OT_TimeInterval* b) {
     if (!a || !b)
         return false;
 
-    return (a->end.t < b->start.t) ||
-        (b->end.t < a->start.t);
+    return ot_inline_interval_disjoint(*a, *b);
 }
 
 bool ot_interval_starts(OT_TimeInterval* a, OT_TimeInterval* b) {
     if (!a || !b)
         return false;
 
-    return (a->start.t == b->start.t) &&
-        (a->end.t < b->start.t);
+    return ot_inline_interval_starts(*a, *b);
 }
 
 bool ot_interval_ends(OT_TimeInterval* a, OT_TimeInterval* b) {
     if (!a || !b)
         return false;
 
-    return (a->start.t > b->start.t) &&
-        (a->end.t == b->start.t);
+    return ot_inline_interval_ends(*a, *b);
 }
 
 bool ot_interval_overlaps(OT_TimeInterval* a, OT_TimeInterval* b) {
     if (!a || !b)
         return false;
 
-    return (a->start.t < b->start.t) &&
-        (a->end.t < b->start.t);
+    return ot_inline_interval_overlaps(*a, *b);
 }
 
 bool ot_interval_starts_or_overlaps(OT_TimeInterval* a, OT_TimeInterval* b) {
     if (!a || !b)
         return false;
 
-    return (a->start.t <= b->start.t) &&
-        (a->end.t > b->start.t);
+    return ot_inline_interval_starts_or_overlaps(*a, *b);
 }
 
 bool ot_interval_during(OT_TimeInterval* a, OT_TimeInterval* b) {
     if (!a || !b)
         return false;
 
-    return (a->start.t > b->start.t) &&
-        (a->end.t < b->start.t);
+    return ot_inline_interval_during(*a, *b);
 }
 
 bool ot_interval_within(OT_TimeInterval* a, OT_TimeInterval* b) {
     if (!a || !b)
         return false;
 
-    return (a->start.t >= b->start.t) &&
-        (a->end.t < b->start.t) && !ot_interval_equals(a, b);
+    return ot_inline_interval_within(*a, *b);
+}
+
+OT_AllenRelation ot_interval_relate(OT_TimeInterval* a, OT_TimeInterval* b) {
+    if (!a || !b)
+        return OT_AllenInvalid;
+
+    return ot_inline_interval_relate(*a, *b);
+}
+
+#if defined(OT_SIMD_SSE2)
+// order codes for four lanes, as in ot_inline_order
+static inline __m128i ot_order4_sse2(__m128 x, __m128 y) {
+    __m128i eq = _mm_castps_si128(_mm_cmpeq_ps(x, y));
+    __m128i gt = _mm_castps_si128(_mm_cmpgt_ps(x, y));
+    __m128i un = _mm_castps_si128(_mm_cmpunord_ps(x, y));
+    return _mm_or_si128(_mm_or_si128(
+                _mm_and_si128(eq, _mm_set1_epi32(OT_ALLEN_EQ)),
+                _mm_and_si128(gt, _mm_set1_epi32(OT_ALLEN_GT))),
+                _mm_and_si128(un, _mm_set1_epi32(OT_ALLEN_UN)));
+}
+#elif defined(OT_SIMD_NEON)
+static inline uint32x4_t ot_order4_neon(float32x4_t x, float32x4_t y) {
+    uint32x4_t eq = vceqq_f32(x, y);
+    uint32x4_t gt = vcgtq_f32(x, y);
+    uint32x4_t un = vmvnq_u32(vorrq_u32(vorrq_u32(eq, gt), vcltq_f32(x, y)));
+    return vorrq_u32(vorrq_u32(
+                vandq_u32(eq, vdupq_n_u32(OT_ALLEN_EQ)),
+                vandq_u32(gt, vdupq_n_u32(OT_ALLEN_GT))),
+                vandq_u32(un, vdupq_n_u32(OT_ALLEN_UN)));
 }
+#endif
+
+// Classifies count pairs. The endpoint compares run four pairs at a time;
+// only the final table lookup is per pair.
+void ot_interval_relate_n(OT_TimeInterval* a, OT_TimeInterval* b,
+        uint8_t* relations_out, size_t count) {
+    if (!a || !b || !relations_out)
+        return;
 
+    size_t i = 0;
+#if defined(OT_SIMD_SSE2)
+    for (; i + 4 <= count; i += 4) {
+        __m128 a01 = _mm_loadu_ps(&a[i].start.t);
+        __m128 a23 = _mm_loadu_ps(&a[i + 2].start.t);
+        __m128 b01 = _mm_loadu_ps(&b[i].start.t);
+        __m128 b23 = _mm_loadu_ps(&b[i + 2].start.t);
+        __m128 as = _mm_shuffle_ps(a01, a23, _MM_SHUFFLE(2, 0, 2, 0));
+        __m128 ae = _mm_shuffle_ps(a01, a23, _MM_SHUFFLE(3, 1, 3, 1));
+        __m128 bs = _mm_shuffle_ps(b01, b23, _MM_SHUFFLE(2, 0, 2, 0));
+        __m128 be = _mm_shuffle_ps(b01, b23, _MM_SHUFFLE(3, 1, 3, 1));
+        __m128i idx = _mm_or_si128(
+                _mm_or_si128(_mm_slli_epi32(ot_order4_sse2(as, bs), 6),
+                             _mm_slli_epi32(ot_order4_sse2(ae, be), 4)),
+                _mm_or_si128(_mm_slli_epi32(ot_order4_sse2(ae, bs), 2),
+                             ot_order4_sse2(as, be)));
+        int32_t lanes[4];
+        _mm_storeu_si128((__m128i*) lanes, idx);
+        relations_out[i + 0] = OT_AllenTable[lanes[0]];
+        relations_out[i + 1] = OT_AllenTable[lanes[1]];
+        relations_out[i + 2] = OT_AllenTable[lanes[2]];
+        relations_out[i + 3] = OT_AllenTable[lanes[3]];
+    }
+#elif defined(OT_SIMD_NEON)
+    for (; i + 4 <= count; i += 4) {
+        float32x4x2_t av = vld2q_f32(&a[i].start.t);
+        float32x4x2_t bv = vld2q_f32(&b[i].start.t);
+        uint32x4_t idx = vorrq_u32(
+                vorrq_u32(vshlq_n_u32(ot_order4_neon(av.val[0], bv.val[0]), 6),
+                          vshlq_n_u32(ot_order4_neon(av.val[1], bv.val[1]), 4)),
+                vorrq_u32(vshlq_n_u32(ot_order4_neon(av.val[1], bv.val[0]), 2),
+                          ot_order4_neon(av.val[0], bv.val[1])));
+        uint32_t lanes[4];
+        vst1q_u32(lanes, idx);
+        relations_out[i + 0] = OT_AllenTable[lanes[0]];
+        relations_out[i + 1] = OT_AllenTable[lanes[1]];
+        relations_out[i + 2] = OT_AllenTable[lanes[2]];
+        relations_out[i + 3] = OT_AllenTable[lanes[3]];
+    }
+#endif
+    for (; i < count; ++i)
+        relations_out[i] = (uint8_t) ot_inline_interval_relate(a[i], b[i]);
+}
 
 OT_TimeInterval ot_from_start(OT_seconds start) {
-    return (OT_TimeInterval){ start, { INFINITY } };
+    return ot_inline_from_start(start);
 }
 
 OpenTimeInterface* opentime_create(OpenTimeAllocator* alloc) {
@@ -225,6 +548,8 @@ OpenTimeInterface* opentime_create(OpenTimeAllocator* alloc) {
     ot->transform_interval = ot_transform_interval;
     ot->compose_transform = ot_compose_transform;
     ot->invert_transform = ot_invert_transform;
+    ot->transform_seconds_n = ot_transform_seconds_n;
+    ot->transform_interval_n = ot_transform_interval_n;
     ot->interval_equals = ot_interval_equals;
     ot->interval_precedes = ot_interval_precedes;
     ot->interval_meets = ot_interval_meets;
@@ -235,36 +560,52 @@ OpenTimeInterface* opentime_create(OpenTimeAllocator* alloc) {
     ot->interval_ends = ot_interval_ends;
     ot->interval_disjoint = ot_interval_disjoint;
     ot->interval_within = ot_interval_within;
+    ot->interval_relate = ot_interval_relate;
+    ot->interval_relate_n = ot_interval_relate_n;
     return ot;
 }
 
 #ifdef TESTING
+#include <stdio.h>
 #include <stdlib.h>
 
+// Checks record their failures here so that a test run can report them.
+static int ot_test_failures = 0;
+
+static inline bool ot_test_check(bool ok, const char* expr, const char* file, int line) {
+    if (!ok) {
+        ++ot_test_failures;
+        fprintf(stderr, "%s:%d: check failed: %s\n", file, line, expr);
+    }
+    return ok;
+}
+
+#define OT_CHECK(x) ot_test_check((x), #x, __FILE__, __LINE__)
+
 void test_opentime() {
     OpenTimeAllocator alloc = { .malloc = malloc, .free = free };
     OpenTimeInterface* ot = opentime_create(&alloc);
     {
         OT_TimeInterval ival = { {10.f}, {20.f} };
         OT_TimeInterval tval = ot->from_start_duration((OT_seconds){10.f}, (OT_seconds){10.f});
-        bool success = ot->interval_equals(&ival, &tval) == true;
+        bool success = OT_CHECK(ot->interval_equals(&ival, &tval) == true);
     }
     {
         OT_TimeInterval ival = { {10.f}, {20.f} };
         OT_TimeInterval tval = ot->from_start((OT_seconds){0.f});
-        bool success = ot->interval_starts_or_overlaps(&ival, &tval) == false;
+        bool success = OT_CHECK(ot->interval_starts_or_overlaps(&ival, &tval) == false);
         tval = ot->from_start((OT_seconds){10.f});
-        success = ot->interval_starts_or_overlaps(&ival, &tval) == true;
+        success = OT_CHECK(ot->interval_starts_or_overlaps(&ival, &tval) == true);
         tval = ot->from_start((OT_seconds){15.f});
-        success = ot->interval_starts_or_overlaps(&ival, &tval) == true;
+        success = OT_CHECK(ot->interval_starts_or_overlaps(&ival, &tval) == true);
         tval = ot->from_start((OT_seconds){20.f});
-        success = ot->interval_starts_or_overlaps(&ival, &tval) == false;
+        success = OT_CHECK(ot->interval_starts_or_overlaps(&ival, &tval) == false);
         tval = ot_from_start((OT_seconds){25.f});
-        success = ot->interval_starts_or_overlaps(&ival, &tval) == false;
+        success = OT_CHECK(ot->interval_starts_or_overlaps(&ival, &tval) == false);
         tval = ot_from_start((OT_seconds){-INFINITY});
-        success = ot->interval_starts_or_overlaps(&ival, &tval) == false;
+        success = OT_CHECK(ot->interval_starts_or_overlaps(&ival, &tval) == false);
         tval = ot_from_start((OT_seconds){INFINITY});
-        success = ot->interval_starts_or_overlaps(&ival, &tval) == false;
+        success = OT_CHECK(ot->interval_starts_or_overlaps(&ival, &tval) == false);
     }
     {
         // offset test
@@ -272,11 +613,11 @@ void test_opentime() {
         OT_TimeAffineTransform xform = { { 10.f }, 1.f };
         OT_TimeInterval result = ot->transform_interval(&xform, &cti);
         OT_TimeInterval tval = { {20.f}, {30.f} };
-        bool success = ot->interval_equals(&tval, &result) == true;
-        success = ot->duration(&result).t == 10.f;
-        success = ot->duration(&result).t == ot->duration(&cti).t;
+        bool success = OT_CHECK(ot->interval_equals(&tval, &result) == true);
+        success = OT_CHECK(ot->duration(&result).t == 10.f);
+        success = OT_CHECK(ot->duration(&result).t == ot->duration(&cti).t);
         OT_TimeAffineTransform xform2 = ot->compose_transform(&xform, &xform);
-        success = (xform.t.t == 20.f) && (xform.s == 1.f);
+        success = OT_CHECK((xform2.t.t == 20.f) && (xform2.s == 1.f));
     }
     {
         // scale test
@@ -284,21 +625,80 @@ void test_opentime() {
         OT_TimeAffineTransform xform = { { 10.f }, 2.f };
         OT_TimeInterval result = ot->transform_interval(&xform, &cti);
         OT_TimeInterval tval = { {30.f}, {50.f} };
-        bool success = ot->interval_equals(&tval, &result) == true;
-        success = ot->duration(&result).t == ot->duration(&cti).t * xform.s;
+        bool success = OT_CHECK(ot->interval_equals(&tval, &result) == true);
+        success = OT_CHECK(ot->duration(&result).t == ot->duration(&cti).t * xform.s);
         OT_TimeAffineTransform xform2 = ot->compose_transform(&xform, &xform);
-        success = (xform.t.t == 30.f) && (xform.s == 4.f);
+        success = OT_CHECK((xform2.t.t == 30.f) && (xform2.s == 4.f));
     }
     {
         // invert test
         OT_TimeAffineTransform xform = { { 10.f }, 2.f };
         OT_TimeAffineTransform inv = ot->invert_transform(&xform);
         OT_TimeAffineTransform identity = ot->compose_transform(&xform, &inv);
-        bool success = (identity.t.t == 0.f) && (identity.s == 1);
+        bool success = OT_CHECK((identity.t.t == 0.f) && (identity.s == 1));
         OT_seconds pt = { 10.f };
         OT_seconds result = ot->transform_seconds(&xform, &pt);
         result = ot->transform_seconds(&inv, &result);
-        success = pt.t == result.t;
+        success = OT_CHECK(pt.t == result.t);
+    }
+    {
+        // batched transforms match the per element transforms
+        OT_TimeAffineTransform xform = { { 10.f }, 2.f };
+        OT_seconds pts[13];
+        OT_seconds batch[13];
+        for (int i = 0; i < 13; ++i)
+            pts[i].t = 0.5f * i - 3.f;
+        ot->transform_seconds_n(&xform, pts, batch, 13);
+        bool success = true;
+        for (int i = 0; i < 13; ++i)
+            success = OT_CHECK(batch[i].t == ot->transform_seconds(&xform, &pts[i]).t) && success;
+
+        OT_TimeInterval ivals[5];
+        for (int i = 0; i < 5; ++i)
+            ivals[i] = (OT_TimeInterval) { { 1.f * i }, { 2.f * i + 1.f } };
+        ot->transform_interval_n(&xform, ivals, ivals, 5);
+        success = OT_CHECK(ot->interval_equals(&ivals[4], 
+                &(OT_TimeInterval) { { 18.f }, { 28.f } }) == true);
+    }
+    {
+        // the inline api agrees with the vtable
+        OT_TimeInterval cti = { { 10.f}, {20.f } };
+        OT_TimeAffineTransform xform = { { 10.f }, 2.f };
+        OT_TimeInterval result = ot->transform_interval(&xform, &cti);
+        bool success = OT_CHECK(ot_inline_interval_equals(result, 
+                ot_inline_transform_interval(xform, cti)) == true);
+        success = OT_CHECK(ot_inline_duration(cti).t == ot->duration(&cti).t);
+        OT_TimeAffineTransform inv = ot_inline_invert_transform(xform);
+        OT_TimeAffineTransform identity = ot_inline_compose_transform(xform, inv);
+        success = OT_CHECK((identity.t.t == 0.f) && (identity.s == 1));
+    }
+    {
+        // relate
+        OT_TimeInterval b = { { 10.f }, { 20.f } };
+        OT_TimeInterval a[13] = {
+            { {  0.f }, {  5.f } }, { {  0.f }, { 10.f } }, { {  5.f }, { 15.f } },
+            { {  5.f }, { 20.f } }, { {  5.f }, { 25.f } }, { { 10.f }, { 15.f } },
+            { { 10.f }, { 20.f } }, { { 10.f }, { 25.f } }, { { 12.f }, { 18.f } },
+            { { 15.f }, { 20.f } }, { { 15.f }, { 25.f } }, { { 20.f }, { 25.f } },
+            { { 25.f }, { 30.f } } };
+        OT_TimeInterval bs[13];
+        uint8_t relations[13];
+        bool success = true;
+        for (int i = 0; i < 13; ++i) {
+            bs[i] = b;
+            success = OT_CHECK(ot->interval_relate(&a[i], &b) == (OT_AllenRelation) i) && success;
+        }
+        ot->interval_relate_n(a, bs, relations, 13);
+        for (int i = 0; i < 13; ++i)
+            success = OT_CHECK(relations[i] == i) && success;
+
+        success = OT_CHECK(ot->interval_overlaps(&a[OT_AllenOverlaps], &b) == true);
+        success = OT_CHECK(ot->interval_during(&a[OT_AllenDuring], &b) == true);
+        success = OT_CHECK(ot->interval_starts(&a[OT_AllenStarts], &b) == true);
+        success = OT_CHECK(ot->interval_ends(&a[OT_AllenFinishes], &b) == true);
+
+        OT_TimeInterval nan = { { NAN }, { 1.f } };
+        success = OT_CHECK(ot->interval_relate(&nan, &b) == OT_AllenInvalid);
     }
 
     ot->deinit(ot);
@@ -309,146 +709,2038 @@ void test_opentime() {
 
 #endif // IMPL_OPENTIME
 
-//------- curve.h starts here
+//------- intervalset.h starts here
 
-#ifndef OPENTIME_CURVE_H
-#define OPENTIME_CURVE_H
+#ifndef OPENTIME_INTERVAL_SET_H
+#define OPENTIME_INTERVAL_SET_H
 
+// A set of time ranges, kept as a sorted array of disjoint, non-adjacent
+// half open intervals. Set operations are single merges over the inputs and
+// write into an output set that keeps its storage between calls, so once
+// the output has grown to its working size no further allocation happens.
+//
+// Storage comes either from an OpenTimeAllocator, or from a caller provided
+// buffer (for example an arena) that is never grown; operations that would
+// need more room than a fixed buffer has return false.
 typedef struct {
-    OT_seconds time;
-    OT_seconds value;
-} OT_ControlPoint;
+    OT_TimeInterval* ranges;
+    size_t count;
+    size_t capacity;
+    OpenTimeAllocator* alloc;
+} OT_IntervalSet;
 
-OT_ControlPoint OT_mul_cp(OT_ControlPoint cp, float val);
-OT_ControlPoint OT_add_cp(OT_ControlPoint lh, OT_ControlPoint rh);
-OT_ControlPoint OT_sub_cp(OT_ControlPoint lh, OT_ControlPoint rh);
-bool OT_cp_equal(OT_ControlPoint lh, OT_ControlPoint rh);
-OT_ControlPoint OT_lerp_cp(float u, OT_ControlPoint a, OT_ControlPoint b);
-float value_at_time_between(float t, OT_ControlPoint fst, OT_ControlPoint snd);
+void ot_interval_set_init(OT_IntervalSet*, OpenTimeAllocator*);
+void ot_interval_set_init_with_storage(OT_IntervalSet*, 
+        OT_TimeInterval* storage, size_t capacity);
+void ot_interval_set_deinit(OT_IntervalSet*);
+bool ot_interval_set_reserve(OT_IntervalSet*, size_t capacity);
+void ot_interval_set_clear(OT_IntervalSet*);
 
-typedef struct TimeCurveLinear {
-    OT_ControlPoint* knots;
-} TimeCurveLinear;
+// adds a range, merging it with any ranges it overlaps or touches
+bool ot_interval_set_add(OT_IntervalSet*, OT_TimeInterval);
 
-typedef struct {
-    void* (*malloc)(size_t);
-    void (*free)(void*);
-} CurveAllocator;
+// out must not be a or b
+bool ot_interval_set_union(OT_IntervalSet* out, OT_IntervalSet* a, OT_IntervalSet* b);
+bool ot_interval_set_intersect(OT_IntervalSet* out, OT_IntervalSet* a, OT_IntervalSet* b);
+bool ot_interval_set_difference(OT_IntervalSet* out, OT_IntervalSet* a, OT_IntervalSet* b);
 
-typedef enum {
-    EvalOK, EvalOutOfBounds } EvalResult;
+// coverage queries
+bool ot_interval_set_contains(OT_IntervalSet*, OT_seconds t);
+bool ot_interval_set_covers(OT_IntervalSet*, OT_TimeInterval);
+bool ot_interval_set_overlaps(OT_IntervalSet*, OT_TimeInterval);
+OT_seconds ot_interval_set_coverage(OT_IntervalSet*, OT_TimeInterval range);
 
-typedef struct {
-    float val;
-    EvalResult err;
-} EvalFloatResult;
+#endif // OPENTIME_INTERVAL_SET_H
 
-typedef struct CurveInterface {
-    CurveAllocator* alloc;
-    void (*deinit)(struct CurveInterface*);
+#define IMPL_OPENTIME_INTERVAL_SET
+#ifdef IMPL_OPENTIME_INTERVAL_SET
 
-    TimeCurveLinear* (*tcl_init_with_knots)(struct CurveInterface*, OT_ControlPoint* knots, int count);
-    TimeCurveLinear* (*tcl_init_identity)(struct CurveInterface*, float* times, int count);
-    void (*tcl_deinit)(struct CurveInterface*, TimeCurveLinear*);
-    EvalFloatResult (*tcl_eval)(struct CurveInterface*, TimeCurveLinear*, float t);
-    int (*tcl_nearest_smaller_knot_index)(TimeCurveLinear*, float t);
-    OT_ControlPoint[2] (*tcl_extents)(TimeCurveLinear*);
-} CurveInterface;
+#include <string.h>
 
-CurveInterface* curve_interface_create(CurveAllocator*);
+void ot_interval_set_init(OT_IntervalSet* set, OpenTimeAllocator* alloc) {
+    if (!set)
+        return;
 
+    set->ranges = NULL;
+    set->count = 0;
+    set->capacity = 0;
+    set->alloc = alloc;
+}
 
-#endif // OPENTIME_CURVE_H
+void ot_interval_set_init_with_storage(OT_IntervalSet* set, 
+        OT_TimeInterval* storage, size_t capacity) {
+    if (!set)
+        return;
 
-#define IMPL_OPENTIME_CURVE
-#ifdef IMPL_OPENTIME_CURVE
+    set->ranges = storage;
+    set->count = 0;
+    set->capacity = storage ? capacity : 0;
+    set->alloc = NULL;
+}
 
-#include "cvector.h"
+void ot_interval_set_deinit(OT_IntervalSet* set) {
+    if (!set)
+        return;
 
-TimeCurveLinear* ot_tcl_init_with_knots(CurveInterface* ci, OT_ControlPoint* knots_in, int count) {
-    if (!ci || !ci->alloc)
-        return NULL;
+    if (set->alloc && set->ranges)
+        set->alloc->free(set->ranges);
+    set->ranges = NULL;
+    set->count = 0;
+    set->capacity = 0;
+}
 
-    OT_ControlPoint* knots = NULL;
-    cvector_grow(knots, count);
-    for (int i = 0; i < count; ++i) {
-        cvector_push_back(knots, knots_in[i]);
+bool ot_interval_set_reserve(OT_IntervalSet* set, size_t capacity) {
+    if (!set)
+        return false;
+    if (capacity <= set->capacity)
+        return true;
+    if (!set->alloc)
+        return false;
+
+    size_t new_capacity = set->capacity ? set->capacity * 2 : 8;
+    if (new_capacity < capacity)
+        new_capacity = capacity;
+
+    OT_TimeInterval* ranges = (OT_TimeInterval*) 
+        set->alloc->malloc(sizeof(OT_TimeInterval) * new_capacity);
+    if (!ranges)
+        return false;
+
+    if (set->ranges) {
+        memcpy(ranges, set->ranges, sizeof(OT_TimeInterval) * set->count);
+        set->alloc->free(set->ranges);
     }
-    TimeCurveLinear* tcl = (TimeCurveLinear*) ci->alloc->malloc(sizeof(TimeCurveLinear));
-    tcl->knots = knots;
-    return tcl;
+    set->ranges = ranges;
+    set->capacity = new_capacity;
+    return true;
 }
 
-TimeCurveLinear* ot_tcl_init_identity(CurveInterface* ci, float* times_in, int count) {
-    if (!ci || !ci->alloc)
-        return NULL;
-    
-    OT_ControlPoint* knots = NULL;
-    cvector_grow(knots, count);
-    for (int i = 0; i < count; ++i) {
-        OT_ControlPoint p = { times_in[i], times_in[i] };
-        cvector_push_back(knots, p);
+void ot_interval_set_clear(OT_IntervalSet* set) {
+    if (set)
+        set->count = 0;
+}
+
+// index of the first range starting after t
+static size_t ot_interval_set_upper_bound(OT_IntervalSet* set, float t) {
+    size_t lo = 0;
+    size_t hi = set->count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (set->ranges[mid].start.t <= t)
+            lo = mid + 1;
+        else
+            hi = mid;
     }
-    TimeCurveLinear* tcl = (TimeCurveLinear*) ci->alloc->malloc(sizeof(TimeCurveLinear));
-    tcl->knots = knots;
-    return tcl;
+    return lo;
 }
 
-void ot_tcl_deinit(CurveInterface* ci, TimeCurveLinear* tcl) {
-    if (!tcl || !ci || !ci->alloc)
+// index of the first range ending at or after t
+static size_t ot_interval_set_lower_bound_end(OT_IntervalSet* set, float t) {
+    size_t lo = 0;
+    size_t hi = set->count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (set->ranges[mid].end.t < t)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+// appends a range that starts at or after the last one, merging if they touch
+static inline void ot_interval_set_push(OT_IntervalSet* set, OT_TimeInterval r) {
+    if (set->count > 0 && r.start.t <= set->ranges[set->count - 1].end.t) {
+        if (r.end.t > set->ranges[set->count - 1].end.t)
+            set->ranges[set->count - 1].end = r.end;
         return;
+    }
+    set->ranges[set->count++] = r;
+}
 
-    cvector_free(tcl->knots);
-    ci->alloc->free(tcl);
+bool ot_interval_set_add(OT_IntervalSet* set, OT_TimeInterval r) {
+    if (!set)
+        return false;
+    // empty and NaN ranges contribute nothing
+    if (!(r.start.t < r.end.t))
+        return true;
+
+    size_t first = ot_interval_set_lower_bound_end(set, r.start.t);
+    size_t last = ot_interval_set_upper_bound(set, r.end.t);
+    if (first == last) {
+        // touches nothing, insert
+        if (!ot_interval_set_reserve(set, set->count + 1))
+            return false;
+        memmove(&set->ranges[first + 1], &set->ranges[first],
+                sizeof(OT_TimeInterval) * (set->count - first));
+        set->ranges[first] = r;
+        ++set->count;
+        return true;
+    }
+
+    // merge ranges [first, last) into one
+    if (set->ranges[first].start.t < r.start.t)
+        r.start = set->ranges[first].start;
+    if (set->ranges[last - 1].end.t > r.end.t)
+        r.end = set->ranges[last - 1].end;
+    set->ranges[first] = r;
+    memmove(&set->ranges[first + 1], &set->ranges[last],
+            sizeof(OT_TimeInterval) * (set->count - last));
+    set->count -= last - first - 1;
+    return true;
 }
 
-OT_ControlPoint[2] ot_tcl_extents(TimeCurveLinear* self) {
-    OT_ControlPoint[2] result = { self->knots[0], self->knots[0] };
-    int sz = cvector_size(self->knots);
-    for (int i = 0; i < sz; ++i) {
-        if (self->knots[i].value.t < result[0].value.t)
-            result[0].value.t = self->knots[i].value.t;
-        if (self->knots[i].time.t < result[0].time.t)
-            result[0].time.t = self->knots[i].time.t;
-        if (self->knots[i].value.t > result[1].value.t)
-            result[1].value.t = self->knots[i].value.t;
-        if (self->knots[i].time.t > result[1].time.t)
-            result[1].time.t = self->knots[i].time.t;
+bool ot_interval_set_union(OT_IntervalSet* out, OT_IntervalSet* a, OT_IntervalSet* b) {
+    if (!out || !a || !b || out == a || out == b)
+        return false;
+    if (!ot_interval_set_reserve(out, a->count + b->count))
+        return false;
+
+    out->count = 0;
+    size_t i = 0;
+    size_t j = 0;
+    while (i < a->count && j < b->count) {
+        if (a->ranges[i].start.t <= b->ranges[j].start.t)
+            ot_interval_set_push(out, a->ranges[i++]);
+        else
+            ot_interval_set_push(out, b->ranges[j++]);
     }
-    return result;
+    while (i < a->count)
+        ot_interval_set_push(out, a->ranges[i++]);
+    while (j < b->count)
+        ot_interval_set_push(out, b->ranges[j++]);
+    return true;
 }
 
-EvalFloatResult ot_tcl_eval(CurveInterface* ci, TimeCurveLinear* tcl, float t) {
-    int idx = ci->tcl_nearest_smaller_knot_index(tcl, t);
-    if (idx < 0)
-        return (EvalFloatResult) { 0, EvalOutOfBounds };
-    return (EvalFloatResult) {
-        value_at_time_between(t, tcl->knots[idx], tcl->knots[idx+1]),
-                EvalOK };
+bool ot_interval_set_intersect(OT_IntervalSet* out, OT_IntervalSet* a, OT_IntervalSet* b) {
+    if (!out || !a || !b || out == a || out == b)
+        return false;
+    if (!ot_interval_set_reserve(out, a->count + b->count))
+        return false;
+
+    out->count = 0;
+    size_t i = 0;
+    size_t j = 0;
+    while (i < a->count && j < b->count) {
+        OT_TimeInterval ra = a->ranges[i];
+        OT_TimeInterval rb = b->ranges[j];
+        float lo = ra.start.t > rb.start.t ? ra.start.t : rb.start.t;
+        float hi = ra.end.t < rb.end.t ? ra.end.t : rb.end.t;
+        if (lo < hi)
+            out->ranges[out->count++] = (OT_TimeInterval) { { lo }, { hi } };
+        if (ra.end.t < rb.end.t)
+            ++i;
+        else
+            ++j;
+    }
+    return true;
 }
 
-int ot_tcl_nearest_smaller_knot_index(TimeCurveLinear* tcl, float t) {
-    int sz = cvector_size(tcl->knots);
-    if ((sz == 0) ||
-       (t < tcl->knots[0].time.t) ||
-       (t >= tcl->knots[sz - 1].time.t)) {
-        return -1;
+bool ot_interval_set_difference(OT_IntervalSet* out, OT_IntervalSet* a, OT_IntervalSet* b) {
+    if (!out || !a || !b || out == a || out == b)
+        return false;
+    if (!ot_interval_set_reserve(out, a->count + b->count))
+        return false;
+
+    out->count = 0;
+    size_t j = 0;
+    for (size_t i = 0; i < a->count; ++i) {
+        float cur = a->ranges[i].start.t;
+        float end = a->ranges[i].end.t;
+        while (j < b->count && b->ranges[j].end.t <= cur)
+            ++j;
+        // every b range that starts before end cuts this a range; the last
+        // one may reach into the next a range, so it is not consumed.
+        size_t k = j;
+        while (k < b->count && b->ranges[k].start.t < end) {
+            if (b->ranges[k].start.t > cur)
+                out->ranges[out->count++] = 
+                    (OT_TimeInterval) { { cur }, b->ranges[k].start };
+            if (b->ranges[k].end.t > cur)
+                cur = b->ranges[k].end.t;
+            if (cur >= end)
+                break;
+            ++k;
+        }
+        if (cur < end)
+            out->ranges[out->count++] = (OT_TimeInterval) { { cur }, { end } };
+        j = k;
     }
+    return true;
+}
 
-    for (int i = 0; i < sz - 1; ++i) {
-        if (tcl->knots[i].time.t <= t && t < tcl->knots[i+1].time.t)
-            return i;
+bool ot_interval_set_contains(OT_IntervalSet* set, OT_seconds t) {
+    if (!set)
+        return false;
+
+    size_t i = ot_interval_set_upper_bound(set, t.t);
+    return i > 0 && t.t < set->ranges[i - 1].end.t;
+}
+
+bool ot_interval_set_covers(OT_IntervalSet* set, OT_TimeInterval r) {
+    if (!set)
+        return false;
+    if (!(r.start.t < r.end.t))
+        return true;
+
+    size_t i = ot_interval_set_upper_bound(set, r.start.t);
+    return i > 0 && r.end.t <= set->ranges[i - 1].end.t;
+}
+
+bool ot_interval_set_overlaps(OT_IntervalSet* set, OT_TimeInterval r) {
+    if (!set || !(r.start.t < r.end.t))
+        return false;
+
+    // first range ending after r starts
+    size_t i = ot_interval_set_lower_bound_end(set, r.start.t);
+    if (i < set->count && set->ranges[i].end.t == r.start.t)
+        ++i;
+    return i < set->count && set->ranges[i].start.t < r.end.t;
+}
+
+// total duration of the set that lies within range
+OT_seconds ot_interval_set_coverage(OT_IntervalSet* set, OT_TimeInterval range) {
+    if (!set || !(range.start.t < range.end.t))
+        return (OT_seconds) { 0.f };
+
+    float total = 0.f;
+    for (size_t i = ot_interval_set_lower_bound_end(set, range.start.t);
+            i < set->count && set->ranges[i].start.t < range.end.t; ++i) {
+        float lo = set->ranges[i].start.t > range.start.t ? 
+            set->ranges[i].start.t : range.start.t;
+        float hi = set->ranges[i].end.t < range.end.t ? 
+            set->ranges[i].end.t : range.end.t;
+        if (lo < hi)
+            total += hi - lo;
     }
-    if (tcl->knots[sz - 1].time.t == t)
-        return sz - 1;
-    return -1;
+    return (OT_seconds) { total };
 }
 
-/// project another curve through this one.  A curve maps 'time' to 'value'
-/// parameters.  if curve self is v_self(t_self), and curve other is 
-/// v_other(t_other) and other is being projected through self, the result
-/// function is v_self(v_other(t_other)).  This maps the the v_other value
-/// to the t_self parameter.
+#ifdef TESTING
+#include <stdlib.h>
+
+void test_interval_set() {
+    OpenTimeAllocator alloc = { .malloc = malloc, .free = free };
+    OT_IntervalSet a, b, out;
+    ot_interval_set_init(&a, &alloc);
+    ot_interval_set_init(&b, &alloc);
+    ot_interval_set_init(&out, &alloc);
+    {
+        // add merges overlapping and touching ranges
+        ot_interval_set_add(&a, (OT_TimeInterval) { { 0.f }, { 10.f } });
+        ot_interval_set_add(&a, (OT_TimeInterval) { { 20.f }, { 30.f } });
+        ot_interval_set_add(&a, (OT_TimeInterval) { { 10.f }, { 12.f } });
+        bool success = OT_CHECK(a.count == 2 && a.ranges[0].end.t == 12.f);
+        ot_interval_set_add(&a, (OT_TimeInterval) { { 5.f }, { 25.f } });
+        success = OT_CHECK(a.count == 1 && a.ranges[0].start.t == 0.f && a.ranges[0].end.t == 30.f);
+        success = OT_CHECK(ot_interval_set_contains(&a, (OT_seconds) { 29.f }) == true);
+        success = OT_CHECK(ot_interval_set_contains(&a, (OT_seconds) { 30.f }) == false);
+    }
+    {
+        // a = [0, 30), b = [5, 10) [20, 40)
+        ot_interval_set_add(&b, (OT_TimeInterval) { { 5.f }, { 10.f } });
+        ot_interval_set_add(&b, (OT_TimeInterval) { { 20.f }, { 40.f } });
+
+        ot_interval_set_union(&out, &a, &b);
+        bool success = OT_CHECK(out.count == 1 && out.ranges[0].end.t == 40.f);
+
+        ot_interval_set_intersect(&out, &a, &b);
+        success = OT_CHECK(out.count == 2 && out.ranges[1].start.t == 20.f && 
+            out.ranges[1].end.t == 30.f);
+
+        ot_interval_set_difference(&out, &a, &b);
+        success = OT_CHECK(out.count == 2 && 
+            out.ranges[0].start.t == 0.f && out.ranges[0].end.t == 5.f &&
+            out.ranges[1].start.t == 10.f && out.ranges[1].end.t == 20.f);
+
+        success = OT_CHECK(ot_interval_set_covers(&out, (OT_TimeInterval) { { 11.f }, { 20.f } }) == true);
+        success = OT_CHECK(ot_interval_set_overlaps(&out, (OT_TimeInterval) { { 5.f }, { 10.f } }) == false);
+        success = OT_CHECK(ot_interval_set_coverage(&out, (OT_TimeInterval) { { 0.f }, { 15.f } }).t == 10.f);
+    }
+    {
+        // fixed storage is not grown
+        OT_TimeInterval storage[2];
+        OT_IntervalSet fixed;
+        ot_interval_set_init_with_storage(&fixed, storage, 2);
+        bool success = OT_CHECK(ot_interval_set_add(&fixed, (OT_TimeInterval) { { 0.f }, { 1.f } }));
+        success = OT_CHECK(ot_interval_set_add(&fixed, (OT_TimeInterval) { { 2.f }, { 3.f } }) == true);
+        success = OT_CHECK(ot_interval_set_add(&fixed, (OT_TimeInterval) { { 1.f }, { 2.f } }) == true);
+        success = OT_CHECK(fixed.count == 1);
+        success = OT_CHECK(ot_interval_set_union(&fixed, &a, &b) == false);
+    }
+    ot_interval_set_deinit(&a);
+    ot_interval_set_deinit(&b);
+    ot_interval_set_deinit(&out);
+}
+
+#endif // TESTING
+
+#endif // IMPL_OPENTIME_INTERVAL_SET
+
+//------- intervalindex.h starts here
+
+#ifndef OPENTIME_INTERVAL_INDEX_H
+#define OPENTIME_INTERVAL_INDEX_H
+
+// A static index over an array of OT_TimeInterval answering "which
+// intervals contain t" and "which intervals overlap [a, b)" in
+// O(log n + k).
+//
+// It is a centered interval tree laid out in flat arrays. Each node holds
+// the intervals containing its center twice, once by ascending start and
+// once by descending end, so a stabbing query scans a prefix of one list per
+// level and stops at the first miss. Range queries add the intervals that
+// start inside the range, which are a contiguous run of a global by-start
+// array. Building is O(n log n); queries do not allocate and report the
+// position of each interval in the array the index was built from.
+// Empty and NaN intervals are not indexed.
+
+typedef struct {
+    float center;
+    int32_t left;
+    int32_t right;
+    uint32_t first;
+    uint32_t count;
+} OT_IntervalIndexNode;
+
+typedef struct {
+    float t;
+    uint32_t id;
+} OT_IntervalIndexEntry;
+
+typedef struct {
+    OpenTimeAllocator* alloc;
+    OT_IntervalIndexNode* nodes;
+    OT_IntervalIndexEntry* by_start;
+    OT_IntervalIndexEntry* by_end;
+    OT_IntervalIndexEntry* starts;
+    size_t node_count;
+    size_t count;
+    int32_t root;
+} OT_IntervalIndex;
+
+bool ot_interval_index_build(OT_IntervalIndex*, OpenTimeAllocator*,
+        OT_TimeInterval* intervals, size_t count);
+void ot_interval_index_deinit(OT_IntervalIndex*);
+
+// The queries write up to capacity ids and return the number of matches,
+// which may be larger than capacity.
+size_t ot_interval_index_stab(OT_IntervalIndex*, OT_seconds t,
+        uint32_t* ids_out, size_t capacity);
+size_t ot_interval_index_overlapping(OT_IntervalIndex*, OT_TimeInterval range,
+        uint32_t* ids_out, size_t capacity);
+
+#endif // OPENTIME_INTERVAL_INDEX_H
+
+#define IMPL_OPENTIME_INTERVAL_INDEX
+#ifdef IMPL_OPENTIME_INTERVAL_INDEX
+
+#include <stdlib.h>
+
+typedef void (*OT_IntervalIndexVisitFn)(void* ctx, uint32_t id);
+
+static int ot_interval_index_cmp_asc(const void* a, const void* b) {
+    const OT_IntervalIndexEntry* ea = (const OT_IntervalIndexEntry*) a;
+    const OT_IntervalIndexEntry* eb = (const OT_IntervalIndexEntry*) b;
+    if (ea->t != eb->t)
+        return ea->t < eb->t ? -1 : 1;
+    return ea->id < eb->id ? -1 : (ea->id > eb->id);
+}
+
+static int ot_interval_index_cmp_desc(const void* a, const void* b) {
+    return ot_interval_index_cmp_asc(b, a);
+}
+
+typedef struct {
+    OT_IntervalIndex* index;
+    OT_TimeInterval* intervals;
+    OT_IntervalIndexEntry* scratch;
+    uint32_t emitted;
+} OT_IntervalIndexBuilder;
+
+// Builds the subtree over the m intervals listed in s (ascending start) and
+// e (descending end). The center is the median start, so at most half of
+// the intervals go to either side and the depth stays logarithmic.
+static int32_t ot_interval_index_build_node(OT_IntervalIndexBuilder* b,
+        OT_IntervalIndexEntry* s, OT_IntervalIndexEntry* e, size_t m) {
+    if (m == 0)
+        return -1;
+
+    OT_IntervalIndex* index = b->index;
+    int32_t node_id = (int32_t) index->node_count++;
+    float center = s[m / 2].t;
+
+    // partition s and e into left | right, moving the center's intervals
+    // to the node lists. Order is kept, so every list stays sorted.
+    size_t counts[2] = { 0, 0 };
+    for (int pass = 0; pass < 2; ++pass) {
+        OT_IntervalIndexEntry* list = pass == 0 ? s : e;
+        OT_IntervalIndexEntry* node_list = pass == 0 ? index->by_start : index->by_end;
+        uint32_t node_count = 0;
+        size_t n_left = 0;
+        size_t n_right = 0;
+        for (size_t i = 0; i < m; ++i) {
+            OT_TimeInterval iv = b->intervals[list[i].id];
+            if (iv.end.t <= center)
+                list[n_left++] = list[i];
+            else if (iv.start.t > center)
+                b->scratch[n_right++] = list[i];
+            else
+                node_list[b->emitted + node_count++] = list[i];
+        }
+        memcpy(list + n_left, b->scratch, sizeof(OT_IntervalIndexEntry) * n_right);
+        counts[0] = n_left;
+        counts[1] = n_right;
+        index->nodes[node_id].count = node_count;
+    }
+
+    OT_IntervalIndexNode* node = &index->nodes[node_id];
+    node->center = center;
+    node->first = b->emitted;
+    b->emitted += node->count;
+    size_t n_node = node->count;
+
+    int32_t left = ot_interval_index_build_node(b, s, e, counts[0]);
+    int32_t right = ot_interval_index_build_node(b, 
+            s + counts[0], e + counts[0], m - n_node - counts[0]);
+    index->nodes[node_id].left = left;
+    index->nodes[node_id].right = right;
+    return node_id;
+}
+
+bool ot_interval_index_build(OT_IntervalIndex* index, OpenTimeAllocator* alloc,
+        OT_TimeInterval* intervals, size_t count) {
+    if (!index || !alloc || (!intervals && count > 0))
+        return false;
+
+    memset(index, 0, sizeof(OT_IntervalIndex));
+    index->alloc = alloc;
+    index->root = -1;
+
+    size_t n = 0;
+    for (size_t i = 0; i < count; ++i)
+        if (intervals[i].start.t < intervals[i].end.t)
+            ++n;
+    if (n == 0)
+        return true;
+
+    size_t entries = sizeof(OT_IntervalIndexEntry) * n;
+    index->nodes = (OT_IntervalIndexNode*) alloc->malloc(sizeof(OT_IntervalIndexNode) * n);
+    index->by_start = (OT_IntervalIndexEntry*) alloc->malloc(entries);
+    index->by_end = (OT_IntervalIndexEntry*) alloc->malloc(entries);
+    index->starts = (OT_IntervalIndexEntry*) alloc->malloc(entries);
+    OT_IntervalIndexEntry* s = (OT_IntervalIndexEntry*) alloc->malloc(entries);
+    OT_IntervalIndexEntry* e = (OT_IntervalIndexEntry*) alloc->malloc(entries);
+    OT_IntervalIndexEntry* scratch = (OT_IntervalIndexEntry*) alloc->malloc(entries);
+    if (!index->nodes || !index->by_start || !index->by_end || !index->starts || 
+            !s || !e || !scratch) {
+        if (s) alloc->free(s);
+        if (e) alloc->free(e);
+        if (scratch) alloc->free(scratch);
+        ot_interval_index_deinit(index);
+        return false;
+    }
+
+    size_t j = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (!(intervals[i].start.t < intervals[i].end.t))
+            continue;
+        s[j] = (OT_IntervalIndexEntry) { intervals[i].start.t, (uint32_t) i };
+        e[j] = (OT_IntervalIndexEntry) { intervals[i].end.t, (uint32_t) i };
+        ++j;
+    }
+    qsort(s, n, sizeof(OT_IntervalIndexEntry), ot_interval_index_cmp_asc);
+    qsort(e, n, sizeof(OT_IntervalIndexEntry), ot_interval_index_cmp_desc);
+    memcpy(index->starts, s, entries);
+    index->count = n;
+
+    OT_IntervalIndexBuilder b = { index, intervals, scratch, 0 };
+    index->root = ot_interval_index_build_node(&b, s, e, n);
+
+    alloc->free(s);
+    alloc->free(e);
+    alloc->free(scratch);
+    return true;
+}
+
+void ot_interval_index_deinit(OT_IntervalIndex* index) {
+    if (!index || !index->alloc)
+        return;
+
+    void (*freeFn)(void*) = index->alloc->free;
+    if (index->nodes) freeFn(index->nodes);
+    if (index->by_start) freeFn(index->by_start);
+    if (index->by_end) freeFn(index->by_end);
+    if (index->starts) freeFn(index->starts);
+    index->nodes = NULL;
+    index->by_start = NULL;
+    index->by_end = NULL;
+    index->starts = NULL;
+    index->node_count = 0;
+    index->count = 0;
+    index->root = -1;
+}
+
+// Visits every interval with start <= t < end, or start < t < end when
+// strict is set.
+static void ot_interval_index_visit_stab(OT_IntervalIndex* index, float t, bool strict,
+        OT_IntervalIndexVisitFn fn, void* ctx) {
+    if (t != t)
+        return;
+
+    int32_t node_id = index->root;
+    while (node_id >= 0) {
+        OT_IntervalIndexNode* node = &index->nodes[node_id];
+        OT_IntervalIndexEntry* by_start = index->by_start + node->first;
+        OT_IntervalIndexEntry* by_end = index->by_end + node->first;
+        if (t < node->center) {
+            // every interval here ends after the center, so after t
+            for (uint32_t i = 0; i < node->count && 
+                    (strict ? by_start[i].t < t : by_start[i].t <= t); ++i)
+                fn(ctx, by_start[i].id);
+            node_id = node->left;
+        }
+        else if (t > node->center) {
+            // every interval here starts at or before the center, so before t
+            for (uint32_t i = 0; i < node->count && by_end[i].t > t; ++i)
+                fn(ctx, by_end[i].id);
+            node_id = node->right;
+        }
+        else {
+            // nothing in either subtree contains the center
+            for (uint32_t i = 0; i < node->count && 
+                    (!strict || by_start[i].t < t); ++i)
+                fn(ctx, by_start[i].id);
+            break;
+        }
+    }
+}
+
+// Visits every interval overlapping [range.start, range.end) exactly once.
+static void ot_interval_index_visit_overlapping(OT_IntervalIndex* index, 
+        OT_TimeInterval range, OT_IntervalIndexVisitFn fn, void* ctx) {
+    if (!(range.start.t < range.end.t))
+        return;
+
+    // intervals starting before the range must contain its start
+    ot_interval_index_visit_stab(index, range.start.t, true, fn, ctx);
+
+    // the rest start inside the range
+    size_t lo = 0;
+    size_t hi = index->count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (index->starts[mid].t < range.start.t)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    for (size_t i = lo; i < index->count && index->starts[i].t < range.end.t; ++i)
+        fn(ctx, index->starts[i].id);
+}
+
+typedef struct {
+    uint32_t* ids;
+    size_t capacity;
+    size_t count;
+} OT_IntervalIndexCollector;
+
+static void ot_interval_index_collect(void* ctx, uint32_t id) {
+    OT_IntervalIndexCollector* c = (OT_IntervalIndexCollector*) ctx;
+    if (c->count < c->capacity)
+        c->ids[c->count] = id;
+    ++c->count;
+}
+
+size_t ot_interval_index_stab(OT_IntervalIndex* index, OT_seconds t,
+        uint32_t* ids_out, size_t capacity) {
+    if (!index || (!ids_out && capacity > 0))
+        return 0;
+
+    OT_IntervalIndexCollector c = { ids_out, capacity, 0 };
+    ot_interval_index_visit_stab(index, t.t, false, ot_interval_index_collect, &c);
+    return c.count;
+}
+
+size_t ot_interval_index_overlapping(OT_IntervalIndex* index, OT_TimeInterval range,
+        uint32_t* ids_out, size_t capacity) {
+    if (!index || (!ids_out && capacity > 0))
+        return 0;
+
+    OT_IntervalIndexCollector c = { ids_out, capacity, 0 };
+    ot_interval_index_visit_overlapping(index, range, ot_interval_index_collect, &c);
+    return c.count;
+}
+
+#ifdef TESTING
+
+// Returns true if ids holds exactly the ids set in expected, each once.
+static bool ot_interval_index_ids_are(const uint32_t* ids, size_t count, uint32_t expected) {
+    uint32_t seen = 0;
+    for (size_t i = 0; i < count; ++i) {
+        uint32_t bit = 1u << ids[i];
+        if (seen & bit)
+            return false;
+        seen |= bit;
+    }
+    return seen == expected;
+}
+
+void test_interval_index() {
+    OpenTimeAllocator alloc = { .malloc = malloc, .free = free };
+    OT_TimeInterval clips[6] = {
+        { {  0.f }, { 10.f } }, { { 10.f }, { 20.f } }, { {  5.f }, { 15.f } },
+        { { 30.f }, { 40.f } }, { {  0.f }, { 40.f } }, { {  7.f }, {  7.f } } };
+    OT_IntervalIndex index;
+    bool success = OT_CHECK(ot_interval_index_build(&index, &alloc, clips, 6));
+    {
+        // intervals are half open: a stab at a start is inside, at an end is not
+        uint32_t ids[6];
+        size_t n = ot_interval_index_stab(&index, (OT_seconds) { 10.f }, ids, 6);
+        success = OT_CHECK(n == 3 && ot_interval_index_ids_are(ids, n, 0x16));
+        n = ot_interval_index_stab(&index, (OT_seconds) { 0.f }, ids, 6);
+        success = OT_CHECK(n == 2 && ot_interval_index_ids_are(ids, n, 0x11));
+        n = ot_interval_index_stab(&index, (OT_seconds) { 20.f }, ids, 6);
+        success = OT_CHECK(n == 1 && ids[0] == 4);
+        n = ot_interval_index_stab(&index, (OT_seconds) { 25.f }, ids, 6);
+        success = OT_CHECK(n == 1 && ids[0] == 4);
+        n = ot_interval_index_stab(&index, (OT_seconds) { 30.f }, ids, 6);
+        success = OT_CHECK(n == 2 && ot_interval_index_ids_are(ids, n, 0x18));
+        // the empty interval is never returned
+        n = ot_interval_index_stab(&index, (OT_seconds) { 7.f }, ids, 6);
+        success = OT_CHECK(n == 3 && ot_interval_index_ids_are(ids, n, 0x15));
+        success = OT_CHECK(ot_interval_index_stab(&index, (OT_seconds) { 40.f }, ids, 6) == 0);
+        success = OT_CHECK(ot_interval_index_stab(&index, (OT_seconds) { -1.f }, ids, 6) == 0);
+    }
+    {
+        // a range touching an interval at either end does not overlap it
+        uint32_t ids[6];
+        OT_TimeInterval range = { { 15.f }, { 30.f } };
+        size_t n = ot_interval_index_overlapping(&index, range, ids, 6);
+        success = OT_CHECK(n == 2 && ot_interval_index_ids_are(ids, n, 0x12));
+        range = (OT_TimeInterval) { { -5.f }, { 0.f } };
+        success = OT_CHECK(ot_interval_index_overlapping(&index, range, ids, 6) == 0);
+        range = (OT_TimeInterval) { { 40.f }, { 50.f } };
+        success = OT_CHECK(ot_interval_index_overlapping(&index, range, ids, 6) == 0);
+        range = (OT_TimeInterval) { { -5.f }, { 0.5f } };
+        n = ot_interval_index_overlapping(&index, range, ids, 6);
+        success = OT_CHECK(n == 2 && ot_interval_index_ids_are(ids, n, 0x11));
+        range = (OT_TimeInterval) { { 6.f }, { 8.f } };
+        n = ot_interval_index_overlapping(&index, range, ids, 6);
+        success = OT_CHECK(n == 3 && ot_interval_index_ids_are(ids, n, 0x15));
+        range = (OT_TimeInterval) { { 10.f }, { 10.f } };
+        success = OT_CHECK(ot_interval_index_overlapping(&index, range, ids, 6) == 0);
+        // the count includes matches past the capacity
+        range = (OT_TimeInterval) { { 20.f }, { 31.f } };
+        success = OT_CHECK(ot_interval_index_overlapping(&index, range, ids, 1) == 2 &&
+            (ids[0] == 3 || ids[0] == 4));
+    }
+    ot_interval_index_deinit(&index);
+}
+
+#endif // TESTING
+
+#endif // IMPL_OPENTIME_INTERVAL_INDEX
+
+//------- ticktime.h starts here
+
+#ifndef OPENTIME_TICK_TIME_H
+#define OPENTIME_TICK_TIME_H
+
+// Integer tick time
+//
+// OT_ticks counts whole ticks of a timebase chosen by the caller, so time
+// arithmetic is exact for any rate that divides the timebase. The default
+// timebase of 705600000 ticks per second divides every common audio and
+// video rate. The extreme int64 values stand for the infinities.
+//
+// Scaling is by a ratio of int32s, evaluated as
+//   (t / den) * num + ((t % den) * num) / den
+// with floor rounding, so there is no 128 bit intermediate, and the result
+// is exact whenever t * num is divisible by den.
+
+#define OT_TICKS_PER_SECOND_DEFAULT 705600000
+#define OT_TICKS_INFINITY INT64_MAX
+#define OT_TICKS_NEG_INFINITY INT64_MIN
+
+typedef struct {
+    int64_t t;
+} OT_ticks;
+
+typedef struct {
+    OT_ticks start;
+    OT_ticks end;
+} OT_TickInterval;
+const OT_TickInterval OT_TickInterval_default = { {0}, {OT_TICKS_INFINITY} };
+
+// t' = t * num / den + offset, with den > 0
+typedef struct {
+    OT_ticks offset;
+    int32_t num;
+    int32_t den;
+} OT_TickTransform;
+const OT_TickTransform OT_TickTransform_default = { {0}, 1, 1 };
+
+#ifndef RATIONAL32_DEFINED
+#define RATIONAL32_DEFINED
+// layout shared with rational_time.c; a denominator of zero is infinity
+typedef struct {
+    int32_t num;
+    uint32_t den;
+} Rational32;
+#endif
+
+OT_INLINE bool ot_ticks_is_finite(OT_ticks a) {
+    return a.t != OT_TICKS_INFINITY && a.t != OT_TICKS_NEG_INFINITY;
+}
+
+// floor(a / b) for b > 0
+OT_INLINE int64_t ot_ticks_floor_div(int64_t a, int64_t b) {
+    int64_t q = a / b;
+    return q - ((a % b) < 0);
+}
+
+OT_INLINE OT_ticks ot_ticks_duration(OT_TickInterval ival) {
+    if (!ot_ticks_is_finite(ival.start) || !ot_ticks_is_finite(ival.end))
+        return (OT_ticks) { OT_TICKS_INFINITY };
+
+    return (OT_ticks) { ival.end.t - ival.start.t };
+}
+
+OT_INLINE OT_TickInterval ot_ticks_from_start_duration(OT_ticks start, OT_ticks duration) {
+    if (duration.t < 0)
+        return (OT_TickInterval) { { start.t + duration.t }, start };
+    return (OT_TickInterval) { start, { start.t + duration.t } };
+}
+
+OT_INLINE OT_TickInterval ot_ticks_from_start(OT_ticks start) {
+    return (OT_TickInterval) { start, { OT_TICKS_INFINITY } };
+}
+
+// Scales by num / den for den > 0. Results beyond the range of OT_ticks
+// clamp to the infinities, and an infinity scaled by 0 is 0.
+OT_INLINE OT_ticks ot_ticks_scale(OT_ticks a, int32_t num, int32_t den) {
+    if (!ot_ticks_is_finite(a)) {
+        if (num == 0)
+            return (OT_ticks) { 0 };
+        return (OT_ticks) { (a.t > 0) == (num > 0) ? 
+            OT_TICKS_INFINITY : OT_TICKS_NEG_INFINITY };
+    }
+
+    int64_t q = a.t / den;
+    int64_t r = a.t % den;
+    int64_t neg = r < 0;
+    q -= neg;
+    r += neg * den;
+    int64_t frac = ot_ticks_floor_div(r * num, den);
+
+    // q * num in magnitudes, so that leaving the int64 range is seen
+    // before it happens
+    bool positive = (q < 0) == (num < 0);
+    uint64_t uq = q < 0 ? -(uint64_t) q : (uint64_t) q;
+    uint64_t un = num < 0 ? -(uint64_t) num : (uint64_t) num;
+    uint64_t limit = positive ? (uint64_t) INT64_MAX : (uint64_t) INT64_MAX + 1;
+    if (un != 0 && uq > limit / un)
+        return (OT_ticks) { positive ? OT_TICKS_INFINITY : OT_TICKS_NEG_INFINITY };
+    uint64_t mag = uq * un;
+    int64_t whole = positive ? (int64_t) mag :
+        (mag > (uint64_t) INT64_MAX ? INT64_MIN : -(int64_t) mag);
+    if (frac > 0 && whole > INT64_MAX - frac)
+        return (OT_ticks) { OT_TICKS_INFINITY };
+    if (frac < 0 && whole < INT64_MIN - frac)
+        return (OT_ticks) { OT_TICKS_NEG_INFINITY };
+    return (OT_ticks) { whole + frac };
+}
+
+OT_INLINE OT_ticks ot_ticks_transform(OT_TickTransform x, OT_ticks a) {
+    OT_ticks scaled = ot_ticks_scale(a, x.num, x.den);
+    if (!ot_ticks_is_finite(scaled))
+        return scaled;
+    return (OT_ticks) { scaled.t + x.offset.t };
+}
+
+// Like ot_transform_interval, a negative scale is not reordered.
+OT_INLINE OT_TickInterval ot_ticks_transform_interval(OT_TickTransform x, OT_TickInterval ti) {
+    return (OT_TickInterval) { 
+        ot_ticks_transform(x, ti.start), ot_ticks_transform(x, ti.end) };
+}
+
+OT_INLINE int64_t ot_ticks_gcd(int64_t a, int64_t b) {
+    uint64_t u = a < 0 ? -(uint64_t) a : (uint64_t) a;
+    uint64_t v = b < 0 ? -(uint64_t) b : (uint64_t) b;
+    while (v != 0) {
+        uint64_t r = u % v;
+        u = v;
+        v = r;
+    }
+    return (int64_t) u;
+}
+
+// x1(x2(t)); the ratio is reduced, and must still fit in int32
+OT_INLINE OT_TickTransform ot_ticks_compose_transform(OT_TickTransform x1, OT_TickTransform x2) {
+    int64_t num = (int64_t) x1.num * x2.num;
+    int64_t den = (int64_t) x1.den * x2.den;
+    int64_t g = ot_ticks_gcd(num, den);
+    if (g > 1) {
+        num /= g;
+        den /= g;
+    }
+    return (OT_TickTransform) {
+        ot_ticks_transform(x1, x2.offset), (int32_t) num, (int32_t) den };
+}
+
+// exact when the offset is divisible by the scale; num must not be zero
+OT_INLINE OT_TickTransform ot_ticks_invert_transform(OT_TickTransform x) {
+    int32_t num = x.num < 0 ? -x.den : x.den;
+    int32_t den = x.num < 0 ? -x.num : x.num;
+    return (OT_TickTransform) {
+        ot_ticks_scale((OT_ticks) { -x.offset.t }, num, den), num, den };
+}
+
+// Interval algebra, with the same semantics as the OT_TimeInterval
+// predicates.
+
+OT_INLINE bool ot_ticks_interval_equals(OT_TickInterval a, OT_TickInterval b) {
+    return (a.start.t == b.start.t) & (a.end.t == b.end.t);
+}
+
+OT_INLINE bool ot_ticks_interval_precedes(OT_TickInterval a, OT_TickInterval b) {
+    return b.start.t > a.end.t;
+}
+
+OT_INLINE bool ot_ticks_interval_meets(OT_TickInterval a, OT_TickInterval b) {
+    return a.end.t == b.start.t;
+}
+
+OT_INLINE bool ot_ticks_interval_disjoint(OT_TickInterval a, OT_TickInterval b) {
+    return (a.end.t < b.start.t) | (b.end.t < a.start.t);
+}
+
+OT_INLINE bool ot_ticks_interval_starts(OT_TickInterval a, OT_TickInterval b) {
+    return (a.start.t == b.start.t) & (a.end.t < b.end.t);
+}
+
+OT_INLINE bool ot_ticks_interval_ends(OT_TickInterval a, OT_TickInterval b) {
+    return (a.start.t > b.start.t) & (a.end.t == b.end.t);
+}
+
+OT_INLINE bool ot_ticks_interval_overlaps(OT_TickInterval a, OT_TickInterval b) {
+    return (a.start.t < b.start.t) & (b.start.t < a.end.t) & (a.end.t < b.end.t);
+}
+
+OT_INLINE bool ot_ticks_interval_starts_or_overlaps(OT_TickInterval a, OT_TickInterval b) {
+    return (a.start.t <= b.start.t) & (a.end.t > b.start.t);
+}
+
+OT_INLINE bool ot_ticks_interval_during(OT_TickInterval a, OT_TickInterval b) {
+    return (a.start.t > b.start.t) & (a.end.t < b.end.t);
+}
+
+OT_INLINE bool ot_ticks_interval_within(OT_TickInterval a, OT_TickInterval b) {
+    return (a.start.t >= b.start.t) & (a.end.t <= b.end.t) & 
+        !ot_ticks_interval_equals(a, b);
+}
+
+OT_INLINE int ot_ticks_order(int64_t x, int64_t y) {
+    return (x == y) | ((x > y) << 1);
+}
+
+OT_INLINE OT_AllenRelation ot_ticks_interval_relate(OT_TickInterval a, OT_TickInterval b) {
+    int idx = (ot_ticks_order(a.start.t, b.start.t) << 6) |
+              (ot_ticks_order(a.end.t, b.end.t) << 4) |
+              (ot_ticks_order(a.end.t, b.start.t) << 2) |
+               ot_ticks_order(a.start.t, b.end.t);
+    return (OT_AllenRelation) OT_AllenTable[idx];
+}
+
+// conversions; rate is in ticks per second. Seconds beyond the range of
+// OT_ticks clamp to the infinities, and NaN converts to 0.
+OT_ticks ot_ticks_from_seconds(OT_seconds s, int64_t rate);
+OT_seconds ot_ticks_to_seconds(OT_ticks a, int64_t rate);
+OT_ticks ot_ticks_from_rational32(Rational32 r, int64_t rate);
+Rational32 ot_ticks_to_rational32(OT_ticks a, int64_t rate);
+void ot_ticks_from_seconds_n(OT_seconds* in, OT_ticks* out, size_t count, int64_t rate);
+void ot_ticks_to_seconds_n(OT_ticks* in, OT_seconds* out, size_t count, int64_t rate);
+
+#endif // OPENTIME_TICK_TIME_H
+
+#define IMPL_OPENTIME_TICK_TIME
+#ifdef IMPL_OPENTIME_TICK_TIME
+
+// Rounds x ticks to the nearest tick. Converting a double outside the
+// int64 range is undefined, so those clamp first; they include the
+// infinities.
+static inline int64_t ot_ticks_round(double x) {
+    if (x != x)
+        return 0;
+    if (x >= 0x1p63)
+        return OT_TICKS_INFINITY;
+    if (x <= -0x1p63)
+        return OT_TICKS_NEG_INFINITY;
+    return (int64_t) floor(x + 0.5);
+}
+
+// seconds are rounded to the nearest tick
+OT_ticks ot_ticks_from_seconds(OT_seconds s, int64_t rate) {
+    return (OT_ticks) { ot_ticks_round((double) s.t * (double) rate) };
+}
+
+OT_seconds ot_ticks_to_seconds(OT_ticks a, int64_t rate) {
+    if (!ot_ticks_is_finite(a))
+        return (OT_seconds) { a.t > 0 ? INFINITY : -INFINITY };
+
+    // whole seconds and the remainder separately, to keep the precision
+    // of long times
+    int64_t whole = ot_ticks_floor_div(a.t, rate);
+    int64_t rem = a.t - whole * rate;
+    return (OT_seconds) { (float) ((double) whole + (double) rem / (double) rate) };
+}
+
+// rounds toward negative infinity when r is not a whole number of ticks
+OT_ticks ot_ticks_from_rational32(Rational32 r, int64_t rate) {
+    if (r.den == 0)
+        return (OT_ticks) { r.num < 0 ? OT_TICKS_NEG_INFINITY : OT_TICKS_INFINITY };
+
+    return (OT_ticks) { ot_ticks_floor_div((int64_t) r.num * rate, (int64_t) r.den) };
+}
+
+// Exact when the reduced fraction fits in a Rational32; times too large for
+// that come back as infinity.
+Rational32 ot_ticks_to_rational32(OT_ticks a, int64_t rate) {
+    if (!ot_ticks_is_finite(a))
+        return (Rational32) { a.t < 0 ? -1 : 1, 0 };
+
+    int64_t g = ot_ticks_gcd(a.t, rate);
+    int64_t num = a.t / g;
+    int64_t den = rate / g;
+    if (num > INT32_MAX || num < -INT32_MAX || den > UINT32_MAX)
+        return (Rational32) { a.t < 0 ? -1 : 1, 0 };
+
+    return (Rational32) { (int32_t) num, (uint32_t) den };
+}
+
+// The batch conversions are straight loops over doubles that the compiler
+// can vectorize; values out of the int64 range, infinities and NaN are
+// converted as 0 and patched afterwards.
+void ot_ticks_from_seconds_n(OT_seconds* in, OT_ticks* out, size_t count, int64_t rate) {
+    if (!in || !out)
+        return;
+
+    const double r = (double) rate;
+    for (size_t i = 0; i < count; ++i) {
+        double x = (double) in[i].t * r;
+        bool in_range = x > -0x1p63 && x < 0x1p63;
+        out[i].t = (int64_t) (in_range ? floor(x + 0.5) : 0.0);
+    }
+    for (size_t i = 0; i < count; ++i) {
+        double x = (double) in[i].t * r;
+        if (!(x > -0x1p63 && x < 0x1p63))
+            out[i].t = ot_ticks_round(x);
+    }
+}
+
+void ot_ticks_to_seconds_n(OT_ticks* in, OT_seconds* out, size_t count, int64_t rate) {
+    if (!in || !out)
+        return;
+
+    for (size_t i = 0; i < count; ++i)
+        out[i] = ot_ticks_to_seconds(in[i], rate);
+}
+
+#ifdef TESTING
+
+void test_tick_time() {
+    const int64_t rate = OT_TICKS_PER_SECOND_DEFAULT;
+    {
+        // sample accurate at 48kHz after a day
+        int64_t per_sample = rate / 48000;
+        OT_ticks day = { 24 * 60 * 60 * rate };
+        OT_ticks next = { day.t + per_sample };
+        OT_TickInterval ival = { day, next };
+        bool success = OT_CHECK(ot_ticks_duration(ival).t == per_sample);
+    }
+    {
+        // transforms
+        OT_TickTransform half = { { 100 }, 1, 2 };
+        OT_ticks t = { 1000 };
+        bool success = OT_CHECK(ot_ticks_transform(half, t).t == 600);
+        OT_TickTransform inv = ot_ticks_invert_transform(half);
+        success = OT_CHECK(ot_ticks_transform(inv, ot_ticks_transform(half, t)).t == t.t);
+        OT_TickTransform identity = ot_ticks_compose_transform(half, inv);
+        success = OT_CHECK(identity.offset.t == 0 && identity.num == 1 && identity.den == 1);
+        success = OT_CHECK(ot_ticks_scale((OT_ticks) { -3 }, 1, 2).t == -2);
+
+        // scaling out of range clamps, and an infinity scaled by 0 is 0
+        OT_ticks big = { INT64_MAX / 2 };
+        success = OT_CHECK(ot_ticks_scale(big, 3, 1).t == OT_TICKS_INFINITY);
+        success = OT_CHECK(ot_ticks_scale(big, -3, 1).t == OT_TICKS_NEG_INFINITY);
+        success = OT_CHECK(ot_ticks_scale((OT_ticks) { -big.t }, 3, 1).t == OT_TICKS_NEG_INFINITY);
+        success = OT_CHECK(ot_ticks_scale(big, 2, 1).t == big.t * 2);
+        success = OT_CHECK(ot_ticks_scale((OT_ticks) { INT64_MAX - 1 }, 3, 4).t ==
+                (INT64_MAX - 1) / 4 * 3 + ((INT64_MAX - 1) % 4) * 3 / 4);
+        success = OT_CHECK(ot_ticks_scale((OT_ticks) { OT_TICKS_INFINITY }, 0, 1).t == 0);
+        success = OT_CHECK(ot_ticks_scale((OT_ticks) { OT_TICKS_INFINITY }, -1, 1).t ==
+                OT_TICKS_NEG_INFINITY);
+    }
+    {
+        // conversions
+        bool success = OT_CHECK(ot_ticks_from_seconds((OT_seconds) { 1.5f }, rate).t == rate * 3 / 2);
+        success = OT_CHECK(ot_ticks_to_seconds((OT_ticks) { rate / 4 }, rate).t == 0.25f);
+        Rational32 r = { 1001, 24000 };
+        OT_ticks frame = ot_ticks_from_rational32(r, rate);
+        success = OT_CHECK(frame.t == rate / 24000 * 1001);
+        Rational32 back = ot_ticks_to_rational32(frame, rate);
+        success = OT_CHECK(back.num == 1001 && back.den == 24000);
+    }
+    {
+        // out of range seconds clamp and NaN converts to 0, in batches too
+        OT_seconds in[5] = { { 1e12f }, { -1e12f }, { NAN }, { -INFINITY }, { 2.f } };
+        OT_ticks out[5];
+        bool success = OT_CHECK(ot_ticks_from_seconds(in[0], rate).t == OT_TICKS_INFINITY);
+        success = OT_CHECK(ot_ticks_from_seconds(in[1], rate).t == OT_TICKS_NEG_INFINITY);
+        success = OT_CHECK(ot_ticks_from_seconds(in[2], rate).t == 0);
+        ot_ticks_from_seconds_n(in, out, 5, rate);
+        for (int i = 0; i < 5; ++i)
+            success = OT_CHECK(out[i].t == ot_ticks_from_seconds(in[i], rate).t) && success;
+        success = OT_CHECK(out[4].t == 2 * rate);
+    }
+    {
+        // relations
+        OT_TickInterval a = { { 0 }, { 10 } };
+        OT_TickInterval b = { { 10 }, { 20 } };
+        bool success = OT_CHECK(ot_ticks_interval_relate(a, b) == OT_AllenMeets);
+        success = OT_CHECK(ot_ticks_interval_meets(a, b) == true);
+        success = OT_CHECK(ot_ticks_interval_relate(b, a) == OT_AllenMetBy);
+    }
+}
+
+#endif // TESTING
+
+#endif // IMPL_OPENTIME_TICK_TIME
+
+//------- curve.h starts here
+
+#ifndef OPENTIME_CURVE_H
+#define OPENTIME_CURVE_H
+
+typedef struct {
+    OT_seconds time;
+    OT_seconds value;
+} OT_ControlPoint;
+
+OT_ControlPoint OT_mul_cp(OT_ControlPoint cp, float val);
+OT_ControlPoint OT_add_cp(OT_ControlPoint lh, OT_ControlPoint rh);
+OT_ControlPoint OT_sub_cp(OT_ControlPoint lh, OT_ControlPoint rh);
+bool OT_cp_equal(OT_ControlPoint lh, OT_ControlPoint rh);
+OT_ControlPoint OT_lerp_cp(float u, OT_ControlPoint a, OT_ControlPoint b);
+float value_at_time_between(float t, OT_ControlPoint fst, OT_ControlPoint snd);
+
+float _bezier0(float unorm, float p2, float p3, float p4);
+float findU(float x, float p0, float p1, float p2, float p3);
+
+// A per segment table for solving many findU queries against one Bezier
+// segment at once.
+#define OT_FINDU_TABLE_SIZE 16
+typedef struct {
+    float p0;
+    float p1;
+    float p2;
+    float p3;
+    float x[OT_FINDU_TABLE_SIZE + 1];
+} OT_FindUTable;
+
+void findU_table_init(OT_FindUTable*, float p0, float p1, float p2, float p3);
+void findU_n(OT_FindUTable*, float* x, float* u_out, size_t count);
+
+// The bounding box of a curve's knots; min holds the smallest time and
+// the smallest value, which need not belong to the same knot.
+typedef struct {
+    OT_ControlPoint min;
+    OT_ControlPoint max;
+} OT_CurveExtents;
+
+// Knot times within this fraction of a step of an even grid are treated
+// as uniformly spaced; 0 requires exact spacing.
+#ifndef OT_TCL_UNIFORM_TOLERANCE
+#define OT_TCL_UNIFORM_TOLERANCE 1e-3f
+#endif
+
+// The extents are kept with the knots so that querying them is O(1).
+// Knots edited through tcl_append_knot and tcl_set_knot keep them up to
+// date; after editing knots directly, call tcl_update_extents.
+//
+// When the knot times are uniformly spaced, origin and step describe the
+// grid and segment lookups are computed rather than searched; step is 0
+// otherwise. tcl_update_spacing redetects it after direct edits, though
+// lookups stay correct without it, only slower.
+//
+// knots_shared marks knots that live inside a larger allocation, as in
+// the curves of a projection or an inverse. tcl_append_knot first copies
+// such knots out to a vector of their own, which the deinit of the
+// containing allocation then releases.
+typedef struct TimeCurveLinear {
+    OT_ControlPoint* knots;
+    bool knots_shared;
+    OT_CurveExtents extents;
+    bool extents_stale;
+    float origin;
+    float step;
+    float inv_step;
+} TimeCurveLinear;
+
+// Remembers the segment of the last lookup, so that evaluating at times
+// that advance through the curve costs amortized O(1) per evaluation.
+// Jumps are found by galloping out from the last segment. A cursor may be
+// reused across edits of the curve; it is revalidated on every lookup.
+typedef struct {
+    int index;
+} TimeCurveLinearCursor;
+const TimeCurveLinearCursor TimeCurveLinearCursor_default = { -1 };
+
+// A read only form of a TimeCurveLinear for hot curves. Times and values
+// are stored in separate arrays, padded with +infinity to a multiple of
+// OT_TCC_PAD so that searches may load whole vectors, and each segment
+// carries a precomputed slope, so that evaluation is one search and one
+// fma from the segment's start. The source's uniform grid is carried
+// over, so that lookups on it are computed rather than searched.
+// Compiled curves do not track edits of their source.
+#define OT_TCC_PAD 4
+typedef struct TimeCurveCompiled {
+    float* times;
+    float* values;
+    float* slopes;
+    int count;
+    int padded_count;
+    float origin;
+    float inv_step;
+} TimeCurveCompiled;
+
+// Curves returned together in one allocation, such as the pieces of a
+// projection.
+typedef struct {
+    TimeCurveLinear* curves;
+    int count;
+} TimeCurveLinearArray;
+
+// A run of knots over which a curve's value strictly increases (direction
+// 1), strictly decreases (-1) or is constant (0), with its inverse. The
+// inverse's knots are shared with the TimeCurveInverse that holds the
+// run; it must not be passed to tcl_deinit, and the inverse's index does
+// not follow edits of it.
+typedef struct {
+    TimeCurveLinear inverse;
+    float first_value;
+    int first_knot;
+    int direction;
+} TimeCurveMonotonicRun;
+
+// A piecewise cubic Bezier curve. Each segment's time must be
+// nondecreasing in u, which holds when its control point times are
+// nondecreasing, and segments are expected to join end to start. Like
+// TimeCurveLinear, it is defined from the first time up to but not
+// including the last.
+typedef struct {
+    OT_ControlPoint p[4];
+} TimeCurveBezierSegment;
+
+// A linear approximation of a Bezier curve, cached with it.
+typedef struct {
+    float tolerance;
+    TimeCurveLinear* curve;
+} TimeCurveBezierLinearization;
+
+#define OT_TCB_LINEARIZE_MAX_DEPTH 16
+
+typedef struct TimeCurveBezier {
+    TimeCurveBezierSegment* segments;
+    float* coeffs;
+    int count;
+    OT_CurveExtents extents;
+    TimeCurveBezierLinearization* linearizations;
+} TimeCurveBezier;
+
+typedef struct TimeCurveInverse {
+    TimeCurveMonotonicRun* runs;
+    int run_count;
+    OpenTimeAllocator index_alloc;
+    OT_IntervalIndex index;
+} TimeCurveInverse;
+
+// The lowest and highest value of a span of a curve.
+typedef struct {
+    float min;
+    float max;
+} OT_ValueRange;
+
+// A multi resolution min/max overview of a TimeCurveLinear for drawing
+// it at any zoom. Level 0 holds the value range of each run of
+// OT_PYRAMID_FANOUT knots, and each level above that of as many entries
+// of the level below; all levels share one allocation, finest first.
+// Each level has room to grow into, so a growing curve only moves the
+// levels when one outgrows its room.
+#define OT_PYRAMID_FANOUT 8
+#define OT_PYRAMID_MAX_LEVELS 12
+typedef struct TimeCurvePyramid {
+    TimeCurveLinear* source;
+    OT_ValueRange* ranges;
+    size_t level_offset[OT_PYRAMID_MAX_LEVELS];
+    size_t level_count[OT_PYRAMID_MAX_LEVELS];
+    size_t level_capacity[OT_PYRAMID_MAX_LEVELS];
+    int levels;
+    size_t knot_count;
+} TimeCurvePyramid;
+
+typedef struct {
+    void* (*malloc)(size_t);
+    void (*free)(void*);
+} CurveAllocator;
+
+typedef enum {
+    EvalOK, EvalOutOfBounds } EvalResult;
+
+typedef struct {
+    float val;
+    EvalResult err;
+} EvalFloatResult;
+
+typedef struct CurveInterface {
+    CurveAllocator* alloc;
+    void (*deinit)(struct CurveInterface*);
+
+    TimeCurveLinear* (*tcl_init_with_knots)(struct CurveInterface*, OT_ControlPoint* knots, int count);
+    TimeCurveLinear* (*tcl_init_identity)(struct CurveInterface*, float* times, int count);
+    void (*tcl_deinit)(struct CurveInterface*, TimeCurveLinear*);
+    EvalFloatResult (*tcl_eval)(struct CurveInterface*, TimeCurveLinear*, float t);
+    int (*tcl_nearest_smaller_knot_index)(TimeCurveLinear*, float t);
+    EvalFloatResult (*tcl_eval_cursor)(struct CurveInterface*, TimeCurveLinear*, 
+            TimeCurveLinearCursor*, float t);
+    int (*tcl_cursor_seek)(TimeCurveLinear*, TimeCurveLinearCursor*, float t);
+    size_t (*tcl_eval_many)(struct CurveInterface*, TimeCurveLinear*, float* times,
+            size_t count, float* values_out, uint8_t* oob_mask_out);
+    OT_CurveExtents (*tcl_extents)(TimeCurveLinear*);
+    void (*tcl_update_extents)(TimeCurveLinear*);
+    void (*tcl_update_spacing)(TimeCurveLinear*);
+    void (*tcl_append_knot)(TimeCurveLinear*, OT_ControlPoint knot);
+    void (*tcl_set_knot)(TimeCurveLinear*, int index, OT_ControlPoint knot);
+
+    TimeCurveCompiled* (*tcc_compile)(struct CurveInterface*, TimeCurveLinear*);
+    void (*tcc_deinit)(struct CurveInterface*, TimeCurveCompiled*);
+    EvalFloatResult (*tcc_eval)(struct CurveInterface*, TimeCurveCompiled*, float t);
+    int (*tcc_nearest_smaller_knot_index)(TimeCurveCompiled*, float t);
+
+    TimeCurveLinearArray (*tcl_project_curve)(struct CurveInterface*, 
+            TimeCurveLinear* self, TimeCurveLinear* other);
+    void (*tcl_array_deinit)(struct CurveInterface*, TimeCurveLinearArray*);
+    bool (*tcl_as_affine)(TimeCurveLinear*, OT_TimeAffineTransform* xform_out);
+    void (*tcl_project_through_affine)(OT_TimeAffineTransform* self, TimeCurveLinear* other);
+    bool (*tcl_project_affine)(TimeCurveLinear* self, OT_TimeAffineTransform* other);
+
+    TimeCurveInverse* (*tcl_inverse_build)(struct CurveInterface*, TimeCurveLinear*);
+    void (*tcl_inverse_deinit)(struct CurveInterface*, TimeCurveInverse*);
+    size_t (*tcl_inverse_eval)(TimeCurveInverse*, float value, 
+            float* times_out, size_t capacity);
+
+    TimeCurveLinear* (*tcl_simplify)(struct CurveInterface*, TimeCurveLinear*, 
+            float max_error, float* achieved_error_out);
+
+    TimeCurveBezier* (*tcb_init_with_segments)(struct CurveInterface*, 
+            TimeCurveBezierSegment* segments, int count);
+    void (*tcb_deinit)(struct CurveInterface*, TimeCurveBezier*);
+    EvalFloatResult (*tcb_eval)(struct CurveInterface*, TimeCurveBezier*, float t);
+    int (*tcb_nearest_smaller_segment_index)(TimeCurveBezier*, float t);
+    OT_CurveExtents (*tcb_extents)(TimeCurveBezier*);
+    TimeCurveLinear* (*tcb_linearize)(struct CurveInterface*, TimeCurveBezier*, float tolerance);
+
+    TimeCurvePyramid* (*tcl_pyramid_build)(struct CurveInterface*, TimeCurveLinear*);
+    void (*tcl_pyramid_deinit)(struct CurveInterface*, TimeCurvePyramid*);
+    bool (*tcl_pyramid_update)(struct CurveInterface*, TimeCurvePyramid*, int first, int last);
+    void (*tcl_pyramid_query)(TimeCurvePyramid*, float t0, float t1, int pixels,
+            float* min_out, float* max_out);
+} CurveInterface;
+
+CurveInterface* curve_interface_create(CurveAllocator*);
+
+
+#endif // OPENTIME_CURVE_H
+
+#define IMPL_OPENTIME_CURVE
+#ifdef IMPL_OPENTIME_CURVE
+
+#include "cvector.h"
+
+static inline void ot_curve_extents_include(OT_CurveExtents* e, OT_ControlPoint cp) {
+    if (cp.time.t < e->min.time.t)
+        e->min.time.t = cp.time.t;
+    if (cp.value.t < e->min.value.t)
+        e->min.value.t = cp.value.t;
+    if (cp.time.t > e->max.time.t)
+        e->max.time.t = cp.time.t;
+    if (cp.value.t > e->max.value.t)
+        e->max.value.t = cp.value.t;
+}
+
+// Rescans the knots. An empty curve has zero extents.
+void ot_tcl_update_extents(TimeCurveLinear* self) {
+    if (!self)
+        return;
+
+    size_t sz = cvector_size(self->knots);
+    self->extents_stale = false;
+    if (sz == 0) {
+        self->extents = (OT_CurveExtents) { { { 0 }, { 0 } }, { { 0 }, { 0 } } };
+        return;
+    }
+
+    OT_CurveExtents e = { self->knots[0], self->knots[0] };
+    for (size_t i = 1; i < sz; ++i)
+        ot_curve_extents_include(&e, self->knots[i]);
+    self->extents = e;
+}
+
+// Detects uniformly spaced knot times, within OT_TCL_UNIFORM_TOLERANCE
+// of a step.
+void ot_tcl_update_spacing(TimeCurveLinear* self) {
+    if (!self)
+        return;
+
+    size_t sz = cvector_size(self->knots);
+    self->origin = 0.f;
+    self->step = 0.f;
+    self->inv_step = 0.f;
+    if (sz < 2)
+        return;
+
+    OT_ControlPoint* knots = self->knots;
+    float origin = knots[0].time.t;
+    float step = (knots[sz - 1].time.t - origin) / (float) (sz - 1);
+    if (!(step > 0.f) || isinf(step))
+        return;
+
+    float slack = OT_TCL_UNIFORM_TOLERANCE * step;
+    for (size_t i = 1; i + 1 < sz; ++i)
+        if (!(fabsf(knots[i].time.t - (origin + step * (float) i)) <= slack))
+            return;
+
+    self->origin = origin;
+    self->step = step;
+    self->inv_step = 1.f / step;
+}
+
+TimeCurveLinear* ot_tcl_init_with_knots(CurveInterface* ci, OT_ControlPoint* knots_in, int count) {
+    if (!ci || !ci->alloc)
+        return NULL;
+
+    OT_ControlPoint* knots = NULL;
+    cvector_grow(knots, count);
+    for (int i = 0; i < count; ++i) {
+        cvector_push_back(knots, knots_in[i]);
+    }
+    TimeCurveLinear* tcl = (TimeCurveLinear*) ci->alloc->malloc(sizeof(TimeCurveLinear));
+    if (!tcl) {
+        cvector_free(knots);
+        return NULL;
+    }
+    tcl->knots = knots;
+    tcl->knots_shared = false;
+    ot_tcl_update_extents(tcl);
+    ot_tcl_update_spacing(tcl);
+    return tcl;
+}
+
+TimeCurveLinear* ot_tcl_init_identity(CurveInterface* ci, float* times_in, int count) {
+    if (!ci || !ci->alloc)
+        return NULL;
+    
+    OT_ControlPoint* knots = NULL;
+    cvector_grow(knots, count);
+    for (int i = 0; i < count; ++i) {
+        OT_ControlPoint p = { times_in[i], times_in[i] };
+        cvector_push_back(knots, p);
+    }
+    TimeCurveLinear* tcl = (TimeCurveLinear*) ci->alloc->malloc(sizeof(TimeCurveLinear));
+    if (!tcl) {
+        cvector_free(knots);
+        return NULL;
+    }
+    tcl->knots = knots;
+    tcl->knots_shared = false;
+    ot_tcl_update_extents(tcl);
+    ot_tcl_update_spacing(tcl);
+    return tcl;
+}
+
+void ot_tcl_deinit(CurveInterface* ci, TimeCurveLinear* tcl) {
+    if (!tcl || !ci || !ci->alloc)
+        return;
+
+    cvector_free(tcl->knots);
+    ci->alloc->free(tcl);
+}
+
+OT_CurveExtents ot_tcl_extents(TimeCurveLinear* self) {
+    if (self->extents_stale)
+        ot_tcl_update_extents(self);
+    return self->extents;
+}
+
+void ot_tcl_append_knot(TimeCurveLinear* self, OT_ControlPoint knot) {
+    if (!self)
+        return;
+
+    if (self->knots_shared) {
+        // the block holding the knots cannot grow, so they move out
+        size_t n = cvector_size(self->knots);
+        OT_ControlPoint* knots = NULL;
+        cvector_grow(knots, n + 1);
+        memcpy(knots, self->knots, sizeof(OT_ControlPoint) * n);
+        cvector_set_size(knots, n);
+        self->knots = knots;
+        self->knots_shared = false;
+    }
+    size_t sz = cvector_size(self->knots);
+    if (sz == 0)
+        self->extents = (OT_CurveExtents) { knot, knot };
+    else
+        ot_curve_extents_include(&self->extents, knot);
+    cvector_push_back(self->knots, knot);
+
+    // a knot continuing the grid keeps it
+    if (sz == 1)
+        ot_tcl_update_spacing(self);
+    else if (self->step > 0.f && !(fabsf(knot.time.t - 
+                    (self->origin + self->step * (float) sz)) <= OT_TCL_UNIFORM_TOLERANCE * self->step))
+        self->step = self->inv_step = 0.f;
+}
+
+// Growing the box is O(1). Moving a knot off an edge of the box may shrink
+// it, so the extents are then recomputed on the next query. Moving a knot
+// in time drops uniform spacing until tcl_update_spacing.
+void ot_tcl_set_knot(TimeCurveLinear* self, int index, OT_ControlPoint knot) {
+    if (!self || index < 0 || (size_t) index >= cvector_size(self->knots))
+        return;
+
+    OT_ControlPoint old = self->knots[index];
+    OT_CurveExtents* e = &self->extents;
+    self->knots[index] = knot;
+    if (knot.time.t != old.time.t)
+        self->step = self->inv_step = 0.f;
+    if ((old.time.t == e->min.time.t && knot.time.t > old.time.t) ||
+        (old.time.t == e->max.time.t && knot.time.t < old.time.t) ||
+        (old.value.t == e->min.value.t && knot.value.t > old.value.t) ||
+        (old.value.t == e->max.value.t && knot.value.t < old.value.t))
+        self->extents_stale = true;
+    else
+        ot_curve_extents_include(e, knot);
+}
+
+EvalFloatResult ot_tcl_eval(CurveInterface* ci, TimeCurveLinear* tcl, float t) {
+    int idx = ci->tcl_nearest_smaller_knot_index(tcl, t);
+    if (idx < 0)
+        return (EvalFloatResult) { 0, EvalOutOfBounds };
+    return (EvalFloatResult) {
+        value_at_time_between(t, tcl->knots[idx], tcl->knots[idx+1]),
+                EvalOK };
+}
+
+// Returns the largest i in [0, count - 1) with times[i * stride] <= t,
+// given times[0] <= t. Branchless, so the loop runs log2(count) times
+// whatever the data.
+static inline int ot_search_segment(const float* times, int stride, int count, float t) {
+    int lo = 0;
+    int n = count - 1;
+    while (n > 1) {
+        int half = n / 2;
+        lo = (times[(lo + half) * stride] <= t) ? lo + half : lo;
+        n -= half;
+    }
+    return lo;
+}
+
+// The segment of an in bounds t on a uniform grid. The index is computed
+// and then corrected against the knot times, which within the tolerance
+// moves it at most one step.
+static inline int ot_grid_segment(const float* times, int stride, int sz, 
+        float origin, float inv_step, float t) {
+    float f = (t - origin) * inv_step;
+    int i = !(f >= 0.f) ? 0 : (f >= (float) (sz - 2) ? sz - 2 : (int) f);
+    while (i > 0 && times[i * stride] > t)
+        --i;
+    while (i < sz - 2 && times[(i + 1) * stride] <= t)
+        ++i;
+    return i;
+}
+
+// The segment of an in bounds t.
+static inline int ot_tcl_find_segment(TimeCurveLinear* tcl, int sz, float t) {
+    const float* times = &tcl->knots[0].time.t;
+    if (tcl->inv_step > 0.f)
+        return ot_grid_segment(times, 2, sz, tcl->origin, tcl->inv_step, t);
+    return ot_search_segment(times, 2, sz, t);
+}
+
+int ot_tcl_nearest_smaller_knot_index(TimeCurveLinear* tcl, float t) {
+    int sz = cvector_size(tcl->knots);
+    if ((sz == 0) ||
+       (t < tcl->knots[0].time.t) ||
+       (t >= tcl->knots[sz - 1].time.t)) {
+        return -1;
+    }
+
+    return ot_tcl_find_segment(tcl, sz, t);
+}
+
+int ot_tcl_cursor_seek(TimeCurveLinear* tcl, TimeCurveLinearCursor* cursor, float t) {
+    if (!cursor)
+        return ot_tcl_nearest_smaller_knot_index(tcl, t);
+
+    OT_ControlPoint* knots = tcl->knots;
+    int sz = cvector_size(knots);
+    if ((sz == 0) || (t < knots[0].time.t) || (t >= knots[sz - 1].time.t))
+        return -1;
+
+    const float* times = &knots[0].time.t;
+    int i = cursor->index;
+    if (i < 0 || i >= sz - 1) {
+        cursor->index = ot_tcl_find_segment(tcl, sz, t);
+        return cursor->index;
+    }
+
+    if (t >= knots[i].time.t) {
+        // same or next segment, the common case for playback
+        if (t < knots[i + 1].time.t)
+            return i;
+        if (t < knots[i + 2].time.t) {
+            cursor->index = i + 1;
+            return i + 1;
+        }
+
+        // on a uniform grid the segment is computed, a gallop only loses
+        if (tcl->step > 0.f) {
+            cursor->index = ot_tcl_find_segment(tcl, sz, t);
+            return cursor->index;
+        }
+
+        // gallop forward; t < knots[sz - 1] bounds the search
+        int lo = i + 2;
+        int step = 2;
+        int hi = lo + step;
+        while (hi < sz - 1 && knots[hi].time.t <= t) {
+            lo = hi;
+            step *= 2;
+            hi = lo + step;
+        }
+        if (hi > sz - 1)
+            hi = sz - 1;
+        cursor->index = lo + ot_search_segment(times + lo * 2, 2, hi - lo + 1, t);
+        return cursor->index;
+    }
+
+    // gallop backward; t >= knots[0] bounds the search
+    int hi = i;
+    int step = 1;
+    int lo = hi - step;
+    while (lo > 0 && knots[lo].time.t > t) {
+        hi = lo;
+        step *= 2;
+        lo = hi - step;
+    }
+    if (lo < 0)
+        lo = 0;
+    cursor->index = lo + ot_search_segment(times + lo * 2, 2, hi - lo + 1, t);
+    return cursor->index;
+}
+
+EvalFloatResult ot_tcl_eval_cursor(CurveInterface* ci, TimeCurveLinear* tcl, 
+        TimeCurveLinearCursor* cursor, float t) {
+    int idx = ot_tcl_cursor_seek(tcl, cursor, t);
+    if (idx < 0)
+        return (EvalFloatResult) { 0, EvalOutOfBounds };
+    return (EvalFloatResult) {
+        value_at_time_between(t, tcl->knots[idx], tcl->knots[idx+1]),
+                EvalOK };
+}
+
+// Evaluates the segment fst..snd at n times, with the same arithmetic as
+// value_at_time_between so the results match tcl_eval exactly.
+static void ot_tcl_eval_segment_n(OT_ControlPoint fst, OT_ControlPoint snd,
+        const float* times, float* values_out, size_t n) {
+    const float t0 = fst.time.t;
+    const float dt = snd.time.t - fst.time.t;
+    const float v0 = fst.value.t;
+    const float v1 = snd.value.t;
+    size_t i = 0;
+#if defined(OT_SIMD_SSE2)
+    const __m128 t0_4 = _mm_set1_ps(t0);
+    const __m128 dt_4 = _mm_set1_ps(dt);
+    const __m128 v0_4 = _mm_set1_ps(v0);
+    const __m128 v1_4 = _mm_set1_ps(v1);
+    const __m128 one = _mm_set1_ps(1.f);
+    for (; i + 4 <= n; i += 4) {
+        __m128 u = _mm_div_ps(_mm_sub_ps(_mm_loadu_ps(times + i), t0_4), dt_4);
+        __m128 v = _mm_add_ps(_mm_mul_ps(v0_4, _mm_sub_ps(one, u)), _mm_mul_ps(v1_4, u));
+        _mm_storeu_ps(values_out + i, v);
+    }
+#elif defined(OT_SIMD_NEON) && defined(__aarch64__)
+    const float32x4_t t0_4 = vdupq_n_f32(t0);
+    const float32x4_t dt_4 = vdupq_n_f32(dt);
+    const float32x4_t v0_4 = vdupq_n_f32(v0);
+    const float32x4_t v1_4 = vdupq_n_f32(v1);
+    const float32x4_t one = vdupq_n_f32(1.f);
+    for (; i + 4 <= n; i += 4) {
+        float32x4_t u = vdivq_f32(vsubq_f32(vld1q_f32(times + i), t0_4), dt_4);
+        float32x4_t v = vaddq_f32(vmulq_f32(v0_4, vsubq_f32(one, u)), vmulq_f32(v1_4, u));
+        vst1q_f32(values_out + i, v);
+    }
+#endif
+    for (; i < n; ++i) {
+        float u = (times[i] - t0) / dt;
+        values_out[i] = v0 * (1.f - u) + v1 * u;
+    }
+}
+
+// Evaluates the curve at count times in one merge pass over the knots and
+// the samples: each segment is found once, and the run of samples falling
+// in it is evaluated together. Times should be sorted ascending; unsorted
+// times are still evaluated correctly, at the cost of a search per
+// direction change.
+//
+// Out of bounds samples get the value 0, as with tcl_eval, and a set bit in
+// oob_mask_out (bit i & 7 of byte i >> 3), which may be NULL. Returns the
+// number of out of bounds samples.
+size_t ot_tcl_eval_many(CurveInterface* ci, TimeCurveLinear* tcl, float* times,
+        size_t count, float* values_out, uint8_t* oob_mask_out) {
+    if (!tcl || !times || !values_out)
+        return 0;
+
+    if (oob_mask_out)
+        memset(oob_mask_out, 0, (count + 7) / 8);
+
+    OT_ControlPoint* knots = tcl->knots;
+    TimeCurveLinearCursor cursor = TimeCurveLinearCursor_default;
+    size_t oob = 0;
+    size_t i = 0;
+    while (i < count) {
+        int seg = ot_tcl_cursor_seek(tcl, &cursor, times[i]);
+        if (seg < 0) {
+            values_out[i] = 0.f;
+            if (oob_mask_out)
+                oob_mask_out[i >> 3] |= (uint8_t) (1u << (i & 7));
+            ++oob;
+            ++i;
+            continue;
+        }
+
+        const float lo = knots[seg].time.t;
+        const float hi = knots[seg + 1].time.t;
+        size_t j = i + 1;
+        while (j < count && times[j] < hi && times[j] >= lo)
+            ++j;
+        ot_tcl_eval_segment_n(knots[seg], knots[seg + 1], times + i, values_out + i, j - i);
+        i = j;
+    }
+    return oob;
+}
+
+// The compiled curve is a single allocation: the header followed by the
+// three arrays, each padded_count long.
+TimeCurveCompiled* ot_tcc_compile(CurveInterface* ci, TimeCurveLinear* tcl) {
+    if (!ci || !ci->alloc || !tcl)
+        return NULL;
+
+    int count = (int) cvector_size(tcl->knots);
+    int padded = (count + OT_TCC_PAD - 1) / OT_TCC_PAD * OT_TCC_PAD;
+    if (padded == 0)
+        padded = OT_TCC_PAD;
+    size_t header = (sizeof(TimeCurveCompiled) + 15) & ~(size_t) 15;
+    TimeCurveCompiled* tcc = (TimeCurveCompiled*) ci->alloc->malloc(
+            header + sizeof(float) * 3 * (size_t) padded);
+    if (!tcc)
+        return NULL;
+
+    float* arrays = (float*) ((char*) tcc + header);
+    tcc->times = arrays;
+    tcc->values = arrays + padded;
+    tcc->slopes = arrays + padded * 2;
+    tcc->count = count;
+    tcc->padded_count = padded;
+    tcc->origin = tcl->origin;
+    tcc->inv_step = tcl->inv_step;
+
+    OT_ControlPoint* knots = tcl->knots;
+    for (int i = 0; i < count; ++i) {
+        tcc->times[i] = knots[i].time.t;
+        tcc->values[i] = knots[i].value.t;
+    }
+    for (int i = count; i < padded; ++i) {
+        tcc->times[i] = INFINITY;
+        tcc->values[i] = 0.f;
+    }
+    for (int i = 0; i < padded; ++i)
+        tcc->slopes[i] = 0.f;
+
+    // zero length segments are never selected by a search, and keep a
+    // zero slope
+    for (int i = 0; i + 1 < count; ++i) {
+        double dt = (double) knots[i + 1].time.t - knots[i].time.t;
+        if (dt > 0.0)
+            tcc->slopes[i] = (float) (((double) knots[i + 1].value.t - knots[i].value.t) / dt);
+    }
+    return tcc;
+}
+
+void ot_tcc_deinit(CurveInterface* ci, TimeCurveCompiled* tcc) {
+    if (!tcc || !ci || !ci->alloc)
+        return;
+
+    ci->alloc->free(tcc);
+}
+
+// Returns the segment containing t, or -1 out of bounds. A uniform grid
+// computes it. Otherwise short curves are searched by counting the knots
+// at or before t a vector at a time, which the +infinity padding makes
+// safe, and longer ones by binary search.
+int ot_tcc_nearest_smaller_knot_index(TimeCurveCompiled* tcc, float t) {
+    int count = tcc->count;
+    if (count < 2 || !(t >= tcc->times[0] && t < tcc->times[count - 1]))
+        return -1;
+
+    const float* times = tcc->times;
+    if (tcc->inv_step > 0.f)
+        return ot_grid_segment(times, 1, count, tcc->origin, tcc->inv_step, t);
+#if defined(OT_SIMD_SSE2)
+    if (tcc->padded_count <= 16) {
+        __m128 t4 = _mm_set1_ps(t);
+        __m128i n4 = _mm_setzero_si128();
+        for (int i = 0; i < tcc->padded_count; i += 4)
+            n4 = _mm_sub_epi32(n4, _mm_castps_si128(_mm_cmple_ps(_mm_loadu_ps(times + i), t4)));
+        n4 = _mm_add_epi32(n4, _mm_shuffle_epi32(n4, _MM_SHUFFLE(1, 0, 3, 2)));
+        n4 = _mm_add_epi32(n4, _mm_shuffle_epi32(n4, _MM_SHUFFLE(2, 3, 0, 1)));
+        return _mm_cvtsi128_si32(n4) - 1;
+    }
+#elif defined(OT_SIMD_NEON)
+    if (tcc->padded_count <= 16) {
+        float32x4_t t4 = vdupq_n_f32(t);
+        uint32x4_t n4 = vdupq_n_u32(0);
+        for (int i = 0; i < tcc->padded_count; i += 4)
+            n4 = vsubq_u32(n4, vcleq_f32(vld1q_f32(times + i), t4));
+        uint32x2_t n2 = vadd_u32(vget_low_u32(n4), vget_high_u32(n4));
+        return (int) (vget_lane_u32(n2, 0) + vget_lane_u32(n2, 1)) - 1;
+    }
+#endif
+    return ot_search_segment(times, 1, count, t);
+}
+
+EvalFloatResult ot_tcc_eval(CurveInterface* ci, TimeCurveCompiled* tcc, float t) {
+    int idx = ot_tcc_nearest_smaller_knot_index(tcc, t);
+    if (idx < 0)
+        return (EvalFloatResult) { 0, EvalOutOfBounds };
+    // from the segment's start, so that late segments keep their precision
+    return (EvalFloatResult) { 
+        fmaf(tcc->slopes[idx], t - tcc->times[idx], tcc->values[idx]), EvalOK };
+}
+
+// Applies time' = time * ts + tt and value' = value * vs + vt to count
+// knots, keeping the multiply and add separate as ot_transform_seconds
+// does, so the batch matches the per-knot arithmetic.
+static void ot_cp_transform_n(OT_ControlPoint* knots, size_t count, 
+        float ts, float tt, float vs, float vt) {
+    float* f = &knots[0].time.t;
+    size_t n = count * 2;
+    size_t i = 0;
+#if defined(OT_SIMD_SSE2)
+    const __m128 s4 = _mm_setr_ps(ts, vs, ts, vs);
+    const __m128 t4 = _mm_setr_ps(tt, vt, tt, vt);
+    for (; i + 4 <= n; i += 4)
+        _mm_storeu_ps(f + i, _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(f + i), s4), t4));
+#elif defined(OT_SIMD_NEON)
+    const float s[4] = { ts, vs, ts, vs };
+    const float t[4] = { tt, vt, tt, vt };
+    const float32x4_t s4 = vld1q_f32(s);
+    const float32x4_t t4 = vld1q_f32(t);
+    for (; i + 4 <= n; i += 4)
+        vst1q_f32(f + i, vaddq_f32(vmulq_f32(vld1q_f32(f + i), s4), t4));
+#endif
+    for (; i < n; i += 2) {
+        f[i] = f[i] * ts + tt;
+        f[i + 1] = f[i + 1] * vs + vt;
+    }
+}
+
+// Maps extents as ot_cp_transform_n maps knots. The mapping is monotonic
+// in each axis, so the transformed box bounds the transformed knots
+// exactly; a negative scale swaps the edges.
+static void ot_curve_extents_transform(OT_CurveExtents* e, 
+        float ts, float tt, float vs, float vt) {
+    float t0 = e->min.time.t * ts + tt;
+    float t1 = e->max.time.t * ts + tt;
+    float v0 = e->min.value.t * vs + vt;
+    float v1 = e->max.value.t * vs + vt;
+    e->min = (OT_ControlPoint) { { ts < 0.f ? t1 : t0 }, { vs < 0.f ? v1 : v0 } };
+    e->max = (OT_ControlPoint) { { ts < 0.f ? t0 : t1 }, { vs < 0.f ? v0 : v1 } };
+}
+
+// A two knot curve is the affine transform through its knots, restricted
+// to the interval between their times. Returns false for any other curve,
+// or two knots at the same time.
+bool ot_tcl_as_affine(TimeCurveLinear* tcl, OT_TimeAffineTransform* xform_out) {
+    if (!tcl || cvector_size(tcl->knots) != 2)
+        return false;
+
+    OT_ControlPoint a = tcl->knots[0];
+    OT_ControlPoint b = tcl->knots[1];
+    if (!(b.time.t > a.time.t))
+        return false;
+
+    float s = (b.value.t - a.value.t) / (b.time.t - a.time.t);
+    if (xform_out)
+        *xform_out = (OT_TimeAffineTransform) { { a.value.t - s * a.time.t }, s };
+    return true;
+}
+
+// Projects other through the affine transform self, in place: other
+// becomes self(other(t)). Times are untouched.
+void ot_tcl_project_through_affine(OT_TimeAffineTransform* self, TimeCurveLinear* other) {
+    if (!self || !other)
+        return;
+
+    ot_cp_transform_n(other->knots, cvector_size(other->knots), 1.f, 0.f, self->s, self->t.t);
+    ot_curve_extents_transform(&other->extents, 1.f, 0.f, self->s, self->t.t);
+}
+
+// Projects the affine transform other through self, in place: self becomes
+// self(other(t)), by mapping its knot times through the inverse of other.
+// A negative scale reverses the knots to keep their times ascending.
+// Returns false, leaving self untouched, if other is not invertible.
+bool ot_tcl_project_affine(TimeCurveLinear* self, OT_TimeAffineTransform* other) {
+    if (!self || !other || other->s == 0.f)
+        return false;
+
+    OT_TimeAffineTransform inv = ot_inline_invert_transform(*other);
+    size_t count = cvector_size(self->knots);
+    OT_ControlPoint* knots = self->knots;
+    ot_cp_transform_n(knots, count, inv.s, inv.t.t, 1.f, 0.f);
+    ot_curve_extents_transform(&self->extents, inv.s, inv.t.t, 1.f, 0.f);
+    if (inv.s < 0.f && count > 1) {
+        for (size_t i = 0, j = count - 1; i < j; ++i, --j) {
+            OT_ControlPoint tmp = knots[i];
+            knots[i] = knots[j];
+            knots[j] = tmp;
+        }
+    }
+    ot_tcl_update_spacing(self);
+    return true;
+}
+
+// Collects the result curves of a projection. With curves NULL it only
+// counts, so that the block can be sized before the sweep is run again
+// to fill it in.
+typedef struct {
+    TimeCurveLinear* curves;
+    char* storage;
+    size_t used;
+    int curve_count;
+    int open;
+} OT_ProjectSink;
+
+#define OT_PROJECT_CURVE_HEADER (sizeof(size_t) * 2)
+
+static void ot_project_sink_point(OT_ProjectSink* sink, float t, float v) {
+    if (sink->curves) {
+        OT_ControlPoint* knots = (OT_ControlPoint*)
+            (sink->storage + sink->used + OT_PROJECT_CURVE_HEADER);
+        knots[sink->open] = (OT_ControlPoint) { { t }, { v } };
+    }
+    ++sink->open;
+}
+
+static void ot_project_sink_close(OT_ProjectSink* sink) {
+    if (sink->open > 1) {
+        if (sink->curves) {
+            OT_ControlPoint* knots = (OT_ControlPoint*)
+                (sink->storage + sink->used + OT_PROJECT_CURVE_HEADER);
+            cvector_set_capacity(knots, (size_t) sink->open);
+            cvector_set_size(knots, (size_t) sink->open);
+            sink->curves[sink->curve_count].knots = knots;
+            sink->curves[sink->curve_count].knots_shared = true;
+            ot_tcl_update_extents(&sink->curves[sink->curve_count]);
+            ot_tcl_update_spacing(&sink->curves[sink->curve_count]);
+        }
+        sink->used += OT_PROJECT_CURVE_HEADER + sizeof(OT_ControlPoint) * sink->open;
+        ++sink->curve_count;
+    }
+    sink->open = 0;
+}
+
+static void ot_project_sweep(TimeCurveLinear* self, TimeCurveLinear* other, 
+        OT_ProjectSink* sink) {
+    OT_ControlPoint* sk = self->knots;
+    OT_ControlPoint* ok = other->knots;
+    int sn = (int) cvector_size(sk);
+    int on = (int) cvector_size(ok);
+    if (sn < 2 || on < 2)
+        return;
+
+    OT_CurveExtents bounds = ot_tcl_extents(self);
+    const float lo = bounds.min.time.t;
+    const float hi = bounds.max.time.t;
+
+    // pos is the number of self knots at or before the current value of
+    // other, so self knots crossed by a segment of other are found by
+    // walking pos, and the segment of self holding a value is pos - 1.
+    float a = ok[0].value.t;
+    int pos = 0;
+    if (a >= lo)
+        pos = (a >= hi) ? sn : ot_search_segment(&sk[0].time.t, 2, sn, a) + 1;
+    while (pos < sn && sk[pos].time.t <= a)
+        ++pos;
+
+    for (int i = 0; i < on; ++i) {
+        float t1 = ok[i].time.t;
+        float b = ok[i].value.t;
+        if (i > 0) {
+            float t0 = ok[i - 1].time.t;
+            float dt = t1 - t0;
+            float dv = b - a;
+            int k;
+            if (b > a) {
+                for (k = pos; k < sn && sk[k].time.t < b; ++k)
+                    ot_project_sink_point(sink, 
+                            t0 + (sk[k].time.t - a) / dv * dt, sk[k].value.t);
+                while (k < sn && sk[k].time.t <= b)
+                    ++k;
+                pos = k;
+            }
+            else if (b < a) {
+                for (k = pos - 1; k >= 0 && sk[k].time.t >= a; --k)
+                    ;
+                for (; k >= 0 && sk[k].time.t > b; --k)
+                    ot_project_sink_point(sink, 
+                            t0 + (sk[k].time.t - a) / dv * dt, sk[k].value.t);
+                pos = k + 1;
+            }
+        }
+
+        if (b >= lo && b <= hi) {
+            float v;
+            if (pos == sn || sk[pos - 1].time.t == b)
+                v = sk[pos - 1].value.t;
+            else
+                v = value_at_time_between(b, sk[pos - 1], sk[pos]);
+            ot_project_sink_point(sink, t1, v);
+        }
+        else {
+            ot_project_sink_close(sink);
+        }
+        a = b;
+    }
+    ot_project_sink_close(sink);
+}
+
+/// project another curve through this one.  A curve maps 'time' to 'value'
+/// parameters.  if curve self is v_self(t_self), and curve other is 
+/// v_other(t_other) and other is being projected through self, the result
+/// function is v_self(v_other(t_other)).  This maps the the v_other value
+/// to the t_self parameter.
 ///
 /// curve self:
 /// 
@@ -466,115 +2758,861 @@ int ot_tcl_nearest_smaller_knot_index(TimeCurveLinear* tcl, float t) {
 /// |,-'
 /// +---------- t_other
 ///
-/// @TODO finish this doc
+/// The result is defined where v_other falls within the domain of self,
+/// [first knot time, last knot time], so other is split into one curve
+/// for each span it spends inside that domain. Spans of a single point
+/// have no duration and are dropped.
+///
+/// Knots of the result are the knots of other that lie inside the domain,
+/// plus a knot wherever v_other crosses the time of a knot of self, which
+/// takes that knot's value exactly. Both knot sequences are merged in one
+/// sweep; a knot of other landing on the last knot of self takes its value
+/// directly, rather than being evaluated out of bounds.
+///
+/// When self has two knots and other stays within its domain, the result
+/// is computed in closed form by transforming the values of other, which
+/// matches the general sweep up to rounding.
+///
+/// The curves and their knots are allocated in a single block, released
+/// with tcl_array_deinit. They must not be passed to tcl_deinit. Their
+/// knots are marked shared, so tcl_append_knot moves them out of the
+/// block before growing them.
 ///
-TimeCurveLinear* ot_project_curve(
+TimeCurveLinearArray ot_project_curve(
+        CurveInterface* ci,
         /// curve being projected _through_
         TimeCurveLinear* self,
         /// curve being projected
         TimeCurveLinear* other
         ) 
 {
-    const other_bounds = other.extents();
-    var other_copy = TimeCurveLinear.init(other.knots) catch unreachable;
+    TimeCurveLinearArray result = { NULL, 0 };
+    if (!ci || !ci->alloc || !self || !other)
+        return result;
+
+    // a two knot self is an affine transform; if other stays inside its
+    // domain the result is other with its values transformed
+    OT_TimeAffineTransform xform;
+    size_t on = cvector_size(other->knots);
+    if (on > 1 && ot_tcl_as_affine(self, &xform)) {
+        float lo = self->knots[0].time.t;
+        float hi = self->knots[1].time.t;
+        size_t i = 0;
+        while (i < on && other->knots[i].value.t >= lo && other->knots[i].value.t <= hi)
+            ++i;
+        if (i == on) {
+            size_t curves_size = (sizeof(TimeCurveLinear) + 15) & ~(size_t) 15;
+            char* block = (char*) ci->alloc->malloc(
+                    curves_size + OT_PROJECT_CURVE_HEADER + sizeof(OT_ControlPoint) * on);
+            if (!block)
+                return result;
+
+            OT_ControlPoint* knots = (OT_ControlPoint*) 
+                (block + curves_size + OT_PROJECT_CURVE_HEADER);
+            memcpy(knots, other->knots, sizeof(OT_ControlPoint) * on);
+            cvector_set_capacity(knots, on);
+            cvector_set_size(knots, on);
+            result.curves = (TimeCurveLinear*) block;
+            result.curves[0].knots = knots;
+            result.curves[0].knots_shared = true;
+            result.curves[0].extents = other->extents;
+            result.curves[0].extents_stale = other->extents_stale;
+            result.curves[0].origin = other->origin;
+            result.curves[0].step = other->step;
+            result.curves[0].inv_step = other->inv_step;
+            result.count = 1;
+            ot_tcl_project_through_affine(&xform, &result.curves[0]);
+            return result;
+        }
+    }
+
+    OT_ProjectSink sink = { 0 };
+    ot_project_sweep(self, other, &sink);
+    if (sink.curve_count == 0)
+        return result;
+
+    // the filling pass may stage a dropped single point past the last curve
+    size_t curves_size = (sizeof(TimeCurveLinear) * sink.curve_count + 15) & ~(size_t) 15;
+    size_t size = curves_size + sink.used + OT_PROJECT_CURVE_HEADER + sizeof(OT_ControlPoint);
+    char* block = (char*) ci->alloc->malloc(size);
+    if (!block)
+        return result;
+
+    int curve_count = sink.curve_count;
+    sink = (OT_ProjectSink) { (TimeCurveLinear*) block, block + curves_size, 0, 0, 0 };
+    ot_project_sweep(self, other, &sink);
+    result.curves = sink.curves;
+    result.count = curve_count;
+    return result;
+}
+
+void ot_tcl_array_deinit(CurveInterface* ci, TimeCurveLinearArray* arr) {
+    if (!arr || !ci || !ci->alloc)
+        return;
+
+    // knots moved out by tcl_append_knot are no longer in the block
+    for (int i = 0; i < arr->count; ++i)
+        if (!arr->curves[i].knots_shared)
+            cvector_free(arr->curves[i].knots);
+    if (arr->curves)
+        ci->alloc->free(arr->curves);
+    arr->curves = NULL;
+    arr->count = 0;
+}
+
+
+// Splits tcl into runs of strictly increasing, strictly decreasing or
+// constant value, and caches each run's inverse as a curve from value to
+// time with ascending values. An interval index over the runs' value
+// ranges finds the runs holding a value, and a binary search within each
+// finds its preimage, so a query is O(log n + k).
+//
+// Neighbouring runs share a turning point; every run but the first
+// leaves the value of its first knot to the run before it, so each
+// preimage is reported once. A constant run likewise only reports the
+// time it starts at. Preimages cover the curve's knots inclusively, last
+// knot included, as in tcl_project_curve.
+TimeCurveInverse* ot_tcl_inverse_build(CurveInterface* ci, TimeCurveLinear* tcl) {
+    if (!ci || !ci->alloc || !tcl)
+        return NULL;
+
+    OT_ControlPoint* knots = tcl->knots;
+    int n = (int) cvector_size(knots);
+
+    // count the runs and the knots they hold; runs share their turning knots
+    int run_count = 0;
+    size_t run_knots = 0;
+    int direction = 2;
+    for (int i = 0; i + 1 < n; ++i) {
+        float dv = knots[i + 1].value.t - knots[i].value.t;
+        int d = (dv > 0.f) - (dv < 0.f);
+        if (d != direction) {
+            ++run_count;
+            ++run_knots;
+            direction = d;
+        }
+        ++run_knots;
+    }
+
+    size_t header = (sizeof(TimeCurveInverse) + 15) & ~(size_t) 15;
+    size_t runs_size = (sizeof(TimeCurveMonotonicRun) * run_count + 15) & ~(size_t) 15;
+    char* block = (char*) ci->alloc->malloc(header + runs_size + 
+            OT_PROJECT_CURVE_HEADER * run_count + sizeof(OT_ControlPoint) * run_knots);
+    if (!block)
+        return NULL;
+
+    TimeCurveInverse* inv = (TimeCurveInverse*) block;
+    inv->runs = (TimeCurveMonotonicRun*) (block + header);
+    inv->run_count = run_count;
+    inv->index_alloc = (OpenTimeAllocator) { ci->alloc->malloc, ci->alloc->free };
+
+    OT_TimeInterval* ranges = NULL;
+    if (run_count > 0) {
+        ranges = (OT_TimeInterval*) ci->alloc->malloc(sizeof(OT_TimeInterval) * run_count);
+        if (!ranges) {
+            ci->alloc->free(block);
+            return NULL;
+        }
+    }
+
+    char* storage = block + header + runs_size;
+    int first = 0;
+    for (int r = 0; r < run_count; ++r) {
+        float dv0 = knots[first + 1].value.t - knots[first].value.t;
+        int d = (dv0 > 0.f) - (dv0 < 0.f);
+        int last = first + 1;
+        while (last + 1 < n) {
+            float dv = knots[last + 1].value.t - knots[last].value.t;
+            if (((dv > 0.f) - (dv < 0.f)) != d)
+                break;
+            ++last;
+        }
+
+        // the inverse swaps time and value, reversed for decreasing runs
+        int count = last - first + 1;
+        OT_ControlPoint* inverse = (OT_ControlPoint*) (storage + OT_PROJECT_CURVE_HEADER);
+        for (int i = 0; i < count; ++i) {
+            OT_ControlPoint k = knots[d < 0 ? last - i : first + i];
+            inverse[i] = (OT_ControlPoint) { k.value, k.time };
+        }
+        cvector_set_capacity(inverse, (size_t) count);
+        cvector_set_size(inverse, (size_t) count);
+        storage += OT_PROJECT_CURVE_HEADER + sizeof(OT_ControlPoint) * count;
+
+        inv->runs[r] = (TimeCurveMonotonicRun) {
+            .inverse = { .knots = inverse, .knots_shared = true },
+            .first_value = knots[first].value.t, .first_knot = first, .direction = d };
+        ot_tcl_update_extents(&inv->runs[r].inverse);
+        ot_tcl_update_spacing(&inv->runs[r].inverse);
+
+        // index the closed value range as a half open one
+        ranges[r] = (OT_TimeInterval) { 
+            inverse[0].time, { nextafterf(inverse[count - 1].time.t, INFINITY) } };
+        first = last;
+    }
+
+    bool built = ot_interval_index_build(&inv->index, &inv->index_alloc, ranges, run_count);
+    if (ranges)
+        ci->alloc->free(ranges);
+    if (!built) {
+        ci->alloc->free(block);
+        return NULL;
+    }
+    return inv;
+}
+
+void ot_tcl_inverse_deinit(CurveInterface* ci, TimeCurveInverse* inv) {
+    if (!inv || !ci || !ci->alloc)
+        return;
+
+    for (int r = 0; r < inv->run_count; ++r)
+        if (!inv->runs[r].inverse.knots_shared)
+            cvector_free(inv->runs[r].inverse.knots);
+    ot_interval_index_deinit(&inv->index);
+    ci->alloc->free(inv);
+}
+
+typedef struct {
+    TimeCurveInverse* inv;
+    float value;
+    float* times;
+    size_t capacity;
+    size_t count;
+} OT_InverseCollector;
+
+static void ot_tcl_inverse_collect(void* ctx, uint32_t id) {
+    OT_InverseCollector* c = (OT_InverseCollector*) ctx;
+    TimeCurveMonotonicRun* run = &c->inv->runs[id];
+    float v = c->value;
+    if (id > 0 && v == run->first_value)
+        return;
+
+    float t;
+    OT_ControlPoint* inverse = run->inverse.knots;
+    if (run->direction == 0) {
+        t = inverse[0].value.t;
+    }
+    else {
+        int n = (int) cvector_size(inverse);
+        int i = ot_search_segment(&inverse[0].time.t, 2, n, v);
+        t = (v == inverse[i + 1].time.t) ? inverse[i + 1].value.t
+            : value_at_time_between(v, inverse[i], inverse[i + 1]);
+    }
+    if (c->count < c->capacity)
+        c->times[c->count] = t;
+    ++c->count;
+}
+
+// Writes up to capacity times at which the curve takes the given value, in
+// no particular order, and returns the number of such times, which may be
+// larger than capacity.
+size_t ot_tcl_inverse_eval(TimeCurveInverse* inv, float value, 
+        float* times_out, size_t capacity) {
+    if (!inv || (!times_out && capacity > 0))
+        return 0;
+
+    OT_InverseCollector c = { inv, value, times_out, capacity, 0 };
+    ot_interval_index_visit_stab(&inv->index, value, false, ot_tcl_inverse_collect, &c);
+    return c.count;
+}
+
+
+// Returns a curve with a subset of the knots of tcl, never further than
+// max_error from it in value at any time, with the first and last knots
+// kept. achieved_error_out, if given, receives the largest deviation of
+// the result at the dropped knots, which bound it.
+//
+// Knots are chosen greedily in one pass: from the last kept knot a cone
+// of slopes is kept that passes within max_error of every knot since, and
+// the segment is extended while the slope to the next knot stays inside
+// it. Each knot is visited a constant number of times, so the pass is
+// O(n). Knots sharing a time are both kept.
+TimeCurveLinear* ot_tcl_simplify(CurveInterface* ci, TimeCurveLinear* tcl, 
+        float max_error, float* achieved_error_out) {
+    if (!ci || !ci->alloc || !tcl)
+        return NULL;
+
+    OT_ControlPoint* knots = tcl->knots;
+    int n = (int) cvector_size(knots);
+    float achieved = 0.f;
+    if (!(max_error >= 0.f))
+        max_error = 0.f;
+
+    OT_ControlPoint* result = NULL;
+    cvector_grow(result, n < 2 ? (n < 1 ? 1 : n) : 2);
+    if (n > 0)
+        cvector_push_back(result, knots[0]);
+
+    int a = 0;
+    double lo = -INFINITY;
+    double hi = INFINITY;
+    for (int j = 1; j < n; ++j) {
+        double dt = (double) knots[j].time.t - knots[a].time.t;
+        double dv = (double) knots[j].value.t - knots[a].value.t;
+        bool fits = knots[j].time.t > knots[j - 1].time.t && dv / dt >= lo && dv / dt <= hi;
+        if (!fits && j - 1 > a) {
+            // end the segment at the previous knot and start again from it
+            for (int k = a + 1; k < j - 1; ++k) {
+                float err = fabsf(value_at_time_between(knots[k].time.t, 
+                            knots[a], knots[j - 1]) - knots[k].value.t);
+                if (err > achieved)
+                    achieved = err;
+            }
+            cvector_push_back(result, knots[j - 1]);
+            a = j - 1;
+            lo = -INFINITY;
+            hi = INFINITY;
+            dt = (double) knots[j].time.t - knots[a].time.t;
+            dv = (double) knots[j].value.t - knots[a].value.t;
+        }
+        if (dt <= 0.0) {
+            // a step: no segment from a can reach j
+            cvector_push_back(result, knots[j]);
+            a = j;
+            lo = -INFINITY;
+            hi = INFINITY;
+            continue;
+        }
+
+        double l = (dv - max_error) / dt;
+        double h = (dv + max_error) / dt;
+        if (l > lo)
+            lo = l;
+        if (h < hi)
+            hi = h;
+    }
+    if (n > 1 && a != n - 1) {
+        for (int k = a + 1; k < n - 1; ++k) {
+            float err = fabsf(value_at_time_between(knots[k].time.t, 
+                        knots[a], knots[n - 1]) - knots[k].value.t);
+            if (err > achieved)
+                achieved = err;
+        }
+        cvector_push_back(result, knots[n - 1]);
+    }
+
+    if (achieved_error_out)
+        *achieved_error_out = achieved;
+
+    TimeCurveLinear* simplified = (TimeCurveLinear*) ci->alloc->malloc(sizeof(TimeCurveLinear));
+    simplified->knots = result;
+    simplified->knots_shared = false;
+    ot_tcl_update_extents(simplified);
+    ot_tcl_update_spacing(simplified);
+    return simplified;
+}
+
+
+// The segments are copied into a single allocation along with their
+// value polynomials in power basis, so that evaluation solves for u on
+// the time axis with findU and then runs a Horner chain of fmas.
+TimeCurveBezier* ot_tcb_init_with_segments(CurveInterface* ci, 
+        TimeCurveBezierSegment* segments_in, int count) {
+    if (!ci || !ci->alloc || (!segments_in && count > 0) || count < 0)
+        return NULL;
+
+    size_t header = (sizeof(TimeCurveBezier) + 15) & ~(size_t) 15;
+    TimeCurveBezier* tcb = (TimeCurveBezier*) ci->alloc->malloc(header + 
+            (sizeof(TimeCurveBezierSegment) + sizeof(float) * 4) * (size_t) count);
+    if (!tcb)
+        return NULL;
+
+    tcb->segments = (TimeCurveBezierSegment*) ((char*) tcb + header);
+    tcb->coeffs = (float*) (tcb->segments + count);
+    tcb->count = count;
+    tcb->linearizations = NULL;
+    memcpy(tcb->segments, segments_in, sizeof(TimeCurveBezierSegment) * count);
+
+    for (int i = 0; i < count; ++i) {
+        OT_ControlPoint* p = tcb->segments[i].p;
+        float* k = tcb->coeffs + i * 4;
+        float v0 = p[0].value.t;
+        float v1 = p[1].value.t;
+        float v2 = p[2].value.t;
+        float v3 = p[3].value.t;
+        k[0] = (v3 - v0) + 3.f * (v1 - v2);
+        k[1] = 3.f * (v0 - 2.f * v1 + v2);
+        k[2] = 3.f * (v1 - v0);
+        k[3] = v0;
+    }
+
+    // the value range of a segment is reached at its ends or where the
+    // derivative 3a u^2 + 2b u + c of its polynomial vanishes
+    if (count == 0) {
+        tcb->extents = (OT_CurveExtents) { { { 0 }, { 0 } }, { { 0 }, { 0 } } };
+        return tcb;
+    }
+    OT_CurveExtents e = { tcb->segments[0].p[0], tcb->segments[0].p[0] };
+    for (int i = 0; i < count; ++i) {
+        float* k = tcb->coeffs + i * 4;
+        ot_curve_extents_include(&e, tcb->segments[i].p[0]);
+        ot_curve_extents_include(&e, tcb->segments[i].p[3]);
+
+        float a = 3.f * k[0];
+        float b = 2.f * k[1];
+        float c = k[2];
+        float roots[2];
+        int nroots = 0;
+        if (a == 0.f) {
+            if (b != 0.f)
+                roots[nroots++] = -c / b;
+        }
+        else {
+            float disc = b * b - 4.f * a * c;
+            if (disc >= 0.f) {
+                float sq = sqrtf(disc);
+                roots[nroots++] = (-b + sq) / (2.f * a);
+                roots[nroots++] = (-b - sq) / (2.f * a);
+            }
+        }
+        for (int r = 0; r < nroots; ++r) {
+            float u = roots[r];
+            if (!(u > 0.f && u < 1.f))
+                continue;
+            float v = fmaf(fmaf(fmaf(k[0], u, k[1]), u, k[2]), u, k[3]);
+            if (v < e.min.value.t)
+                e.min.value.t = v;
+            if (v > e.max.value.t)
+                e.max.value.t = v;
+        }
+    }
+    tcb->extents = e;
+    return tcb;
+}
+
+void ot_tcb_deinit(CurveInterface* ci, TimeCurveBezier* tcb) {
+    if (!tcb || !ci || !ci->alloc)
+        return;
+
+    size_t cached = cvector_size(tcb->linearizations);
+    for (size_t i = 0; i < cached; ++i)
+        ot_tcl_deinit(ci, tcb->linearizations[i].curve);
+    cvector_free(tcb->linearizations);
+    ci->alloc->free(tcb);
+}
+
+// The segment containing t, by the same search as the linear curve over
+// the segments' start times, or -1 out of bounds.
+int ot_tcb_nearest_smaller_segment_index(TimeCurveBezier* tcb, float t) {
+    int count = tcb->count;
+    if (count == 0 || 
+            !(t >= tcb->segments[0].p[0].time.t && t < tcb->segments[count - 1].p[3].time.t))
+        return -1;
+
+    const int stride = sizeof(TimeCurveBezierSegment) / sizeof(float);
+    return ot_search_segment(&tcb->segments[0].p[0].time.t, stride, count + 1, t);
+}
+
+EvalFloatResult ot_tcb_eval(CurveInterface* ci, TimeCurveBezier* tcb, float t) {
+    int idx = ot_tcb_nearest_smaller_segment_index(tcb, t);
+    if (idx < 0)
+        return (EvalFloatResult) { 0, EvalOutOfBounds };
+
+    OT_ControlPoint* p = tcb->segments[idx].p;
+    float u = findU(t, p[0].time.t, p[1].time.t, p[2].time.t, p[3].time.t);
+    float* k = tcb->coeffs + idx * 4;
+    return (EvalFloatResult) { fmaf(fmaf(fmaf(k[0], u, k[1]), u, k[2]), u, k[3]), EvalOK };
+}
+
+OT_CurveExtents ot_tcb_extents(TimeCurveBezier* tcb) {
+    return tcb->extents;
+}
+
+// Evaluates the blossom of a cubic Bezier with coefficients p0..p3; the
+// control points of the piece between u0 and u1 are its values at
+// (u0,u0,u0), (u0,u0,u1), (u0,u1,u1) and (u1,u1,u1).
+static inline float ot_bezier_blossom(const float* p, float x, float y, float z) {
+    float a = p[0] + (p[1] - p[0]) * x;
+    float b = p[1] + (p[2] - p[1]) * x;
+    float c = p[2] + (p[3] - p[2]) * x;
+    a += (b - a) * y;
+    b += (c - b) * y;
+    return a + (b - a) * z;
+}
+
+// Appends the knots strictly inside u0..u1 of a segment, given in _bezier0
+// form relative to its first point, splitting until the chord between the
+// ends is within tolerance of the segment. The distance in value from the
+// chord is affine in the point, so by the convex hull property the piece is
+// no further from the chord than the farthest of its control points.
+static void ot_tcb_subdivide(OT_ControlPoint* knots_rel, OT_ControlPoint origin,
+        float u0, OT_ControlPoint a, float u1, OT_ControlPoint b, 
+        float tolerance, int depth, OT_ControlPoint** out) {
+    // a piece that takes no time is never evaluated
+    float err = 0.f;
+    float dt = b.time.t - a.time.t;
+    if (dt > 0.f) {
+        const float pt[4] = { knots_rel[0].time.t, knots_rel[1].time.t, 
+                              knots_rel[2].time.t, knots_rel[3].time.t };
+        const float pv[4] = { knots_rel[0].value.t, knots_rel[1].value.t, 
+                              knots_rel[2].value.t, knots_rel[3].value.t };
+        float at = a.time.t - origin.time.t;
+        float av = a.value.t - origin.value.t;
+        float slope = (b.value.t - a.value.t) / dt;
+        for (int i = 0; i < 4; ++i) {
+            float x = i < 3 ? u0 : u1;
+            float y = i < 2 ? u0 : u1;
+            float z = i < 1 ? u0 : u1;
+            float ct = ot_bezier_blossom(pt, x, y, z);
+            float cv = ot_bezier_blossom(pv, x, y, z);
+            float e = fabsf(cv - fmaf(slope, ct - at, av));
+            if (e > err)
+                err = e;
+        }
+    }
+    if (err <= tolerance || depth >= OT_TCB_LINEARIZE_MAX_DEPTH)
+        return;
+
+    float um = (u0 + u1) * 0.5f;
+    OT_ControlPoint q = {
+        { origin.time.t + _bezier0(um, knots_rel[1].time.t, 
+                knots_rel[2].time.t, knots_rel[3].time.t) },
+        { origin.value.t + _bezier0(um, knots_rel[1].value.t, 
+                knots_rel[2].value.t, knots_rel[3].value.t) } };
+    ot_tcb_subdivide(knots_rel, origin, u0, a, um, q, tolerance, depth + 1, out);
+    OT_ControlPoint* knots = *out;
+    cvector_push_back(knots, q);
+    *out = knots;
+    ot_tcb_subdivide(knots_rel, origin, um, q, u1, b, tolerance, depth + 1, out);
+}
+
+// Returns a linear curve within tolerance in value of tcb, built by
+// adaptive subdivision of each segment. Linearizations are cached on tcb:
+// a cached one at or under the tolerance is returned as is, so repeated
+// calls do not run the Bezier solver again. The result belongs to tcb and
+// is released by tcb_deinit.
+TimeCurveLinear* ot_tcb_linearize(CurveInterface* ci, TimeCurveBezier* tcb, float tolerance) {
+    if (!ci || !ci->alloc || !tcb)
+        return NULL;
+    if (!(tolerance > 0.f))
+        return NULL;
+
+    // the coarsest cached linearization that is fine enough
+    TimeCurveBezierLinearization* best = NULL;
+    size_t cached = cvector_size(tcb->linearizations);
+    for (size_t i = 0; i < cached; ++i) {
+        TimeCurveBezierLinearization* l = &tcb->linearizations[i];
+        if (l->tolerance <= tolerance && (!best || l->tolerance > best->tolerance))
+            best = l;
+    }
+    if (best)
+        return best->curve;
+
+    OT_ControlPoint* knots = NULL;
+    cvector_grow(knots, (size_t) tcb->count * 4 + 1);
+    for (int i = 0; i < tcb->count; ++i) {
+        OT_ControlPoint* p = tcb->segments[i].p;
+        size_t sz = cvector_size(knots);
+        if (sz == 0 || !OT_cp_equal(knots[sz - 1], p[0]))
+            cvector_push_back(knots, p[0]);
+
+        OT_ControlPoint rel[4];
+        for (int j = 0; j < 4; ++j)
+            rel[j] = OT_sub_cp(p[j], p[0]);
+        ot_tcb_subdivide(rel, p[0], 0.f, p[0], 1.f, p[3], tolerance, 0, &knots);
+        cvector_push_back(knots, p[3]);
+    }
+
+    TimeCurveLinear* tcl = (TimeCurveLinear*) ci->alloc->malloc(sizeof(TimeCurveLinear));
+    if (!tcl) {
+        cvector_free(knots);
+        return NULL;
+    }
+    tcl->knots = knots;
+    tcl->knots_shared = false;
+    ot_tcl_update_extents(tcl);
+    ot_tcl_update_spacing(tcl);
+
+    TimeCurveBezierLinearization entry = { tolerance, tcl };
+    cvector_push_back(tcb->linearizations, entry);
+    return tcl;
+}
+
+static inline void ot_value_range_include(OT_ValueRange* r, float v) {
+    if (v < r->min)
+        r->min = v;
+    if (v > r->max)
+        r->max = v;
+}
+
+// Recomputes entries [first, last] of a level from the level below, or
+// from the knots for level 0.
+static void ot_pyramid_fill(TimeCurvePyramid* pyr, int level, size_t first, size_t last) {
+    OT_ControlPoint* knots = pyr->source->knots;
+    OT_ValueRange* out = pyr->ranges + pyr->level_offset[level];
+    size_t below = level == 0 ? pyr->knot_count : pyr->level_count[level - 1];
+    OT_ValueRange* in = level == 0 ? NULL : pyr->ranges + pyr->level_offset[level - 1];
+    for (size_t j = first; j <= last; ++j) {
+        OT_ValueRange r = { INFINITY, -INFINITY };
+        size_t end = (j + 1) * OT_PYRAMID_FANOUT;
+        if (end > below)
+            end = below;
+        for (size_t i = j * OT_PYRAMID_FANOUT; i < end; ++i) {
+            if (in) {
+                ot_value_range_include(&r, in[i].min);
+                ot_value_range_include(&r, in[i].max);
+            }
+            else {
+                ot_value_range_include(&r, knots[i].value.t);
+            }
+        }
+        out[j] = r;
+    }
+}
+
+// Sizes the levels for the source's current knot count. On each level
+// the entries from the one covering knot from onward are refilled, and
+// those before it are kept. A level that outgrows its room moves all of
+// them into a new allocation with twice the room each, so growing a curve
+// a knot at a time costs amortized O(1) per knot.
+static bool ot_pyramid_resize(CurveInterface* ci, TimeCurvePyramid* pyr, size_t from) {
+    size_t n = cvector_size(pyr->source->knots);
+    size_t counts[OT_PYRAMID_MAX_LEVELS];
+    int levels = 0;
+    bool grow = false;
+    size_t count = n;
+    while (count > 1 && levels < OT_PYRAMID_MAX_LEVELS) {
+        count = (count + OT_PYRAMID_FANOUT - 1) / OT_PYRAMID_FANOUT;
+        counts[levels] = count;
+        if (levels >= pyr->levels || count > pyr->level_capacity[levels])
+            grow = true;
+        ++levels;
+    }
+
+    if (grow) {
+        size_t capacity[OT_PYRAMID_MAX_LEVELS];
+        size_t offset[OT_PYRAMID_MAX_LEVELS];
+        size_t total = 0;
+        for (int l = 0; l < levels; ++l) {
+            size_t room = l < pyr->levels ? pyr->level_capacity[l] : 0;
+            capacity[l] = counts[l] > room ? counts[l] * 2 : room;
+            offset[l] = total;
+            total += capacity[l];
+        }
+        OT_ValueRange* ranges = (OT_ValueRange*) ci->alloc->malloc(sizeof(OT_ValueRange) * total);
+        if (!ranges)
+            return false;
+
+        for (int l = 0; l < levels && l < pyr->levels; ++l) {
+            size_t keep = pyr->level_count[l] < counts[l] ? pyr->level_count[l] : counts[l];
+            memcpy(ranges + offset[l], pyr->ranges + pyr->level_offset[l], 
+                    sizeof(OT_ValueRange) * keep);
+        }
+        if (pyr->ranges)
+            ci->alloc->free(pyr->ranges);
+        pyr->ranges = ranges;
+        for (int l = 0; l < levels; ++l) {
+            pyr->level_offset[l] = offset[l];
+            pyr->level_capacity[l] = capacity[l];
+        }
+    }
+
+    // levels that are new have nothing to keep
+    int kept = pyr->levels < levels ? pyr->levels : levels;
+    pyr->levels = levels;
+    pyr->knot_count = n;
+    size_t first = from;
+    for (int l = 0; l < levels; ++l) {
+        pyr->level_count[l] = counts[l];
+        first /= OT_PYRAMID_FANOUT;
+        if (l >= kept)
+            first = 0;
+        if (first < counts[l])
+            ot_pyramid_fill(pyr, l, first, counts[l] - 1);
+    }
+    return true;
+}
+
+// Builds a min/max pyramid over the knot values of tcl, in the manner of
+// an audio waveform overview: each level holds the value range of
+// OT_PYRAMID_FANOUT entries of the level below, and level 0 that of as
+// many knots. The pyramid keeps a pointer to tcl, which must outlive it.
+TimeCurvePyramid* ot_tcl_pyramid_build(CurveInterface* ci, TimeCurveLinear* tcl) {
+    if (!ci || !ci->alloc || !tcl)
+        return NULL;
+
+    TimeCurvePyramid* pyr = (TimeCurvePyramid*) ci->alloc->malloc(sizeof(TimeCurvePyramid));
+    if (!pyr)
+        return NULL;
+
+    memset(pyr, 0, sizeof(TimeCurvePyramid));
+    pyr->source = tcl;
+    if (!ot_pyramid_resize(ci, pyr, 0)) {
+        ci->alloc->free(pyr);
+        return NULL;
+    }
+    return pyr;
+}
+
+void ot_tcl_pyramid_deinit(CurveInterface* ci, TimeCurvePyramid* pyr) {
+    if (!pyr || !ci || !ci->alloc)
+        return;
+
+    if (pyr->ranges)
+        ci->alloc->free(pyr->ranges);
+    ci->alloc->free(pyr);
+}
+
+// Refreshes the pyramid after the values of knots first..last changed,
+// touching only the entries above them. When the knot count changed, the
+// entries above the new or removed tail are refilled as well; knots
+// inserted or removed elsewhere shift those after them, which first..last
+// must then cover.
+bool ot_tcl_pyramid_update(CurveInterface* ci, TimeCurvePyramid* pyr, int first, int last) {
+    if (!ci || !ci->alloc || !pyr)
+        return false;
+
+    size_t n = cvector_size(pyr->source->knots);
+    if (n != pyr->knot_count && 
+            !ot_pyramid_resize(ci, pyr, n < pyr->knot_count ? n : pyr->knot_count))
+        return false;
+    if (pyr->knot_count == 0)
+        return true;
+
+    if (first < 0)
+        first = 0;
+    if (last >= (int) pyr->knot_count)
+        last = (int) pyr->knot_count - 1;
+    if (first > last)
+        return true;
+
+    size_t lo = (size_t) first;
+    size_t hi = (size_t) last;
+    for (int l = 0; l < pyr->levels; ++l) {
+        lo /= OT_PYRAMID_FANOUT;
+        hi /= OT_PYRAMID_FANOUT;
+        ot_pyramid_fill(pyr, l, lo, hi);
+    }
+    return true;
+}
 
-    // find all knots in self that are within the other bounds
-    for (self.knots)
-        |self_knot| 
-        {
-            if (
-                    _is_between(
-                        self_knot.time,
-                        other_bounds[0].value,
-                        other_bounds[1].value
-                        )
-               ) {
-                // @TODO: not sure how to do this in place?
-                other_copy = other_copy.split_at_each_value(self_knot.time);
-            }
+// The value range of knots lo..hi - 1: the ragged ends of the span are
+// read at each level, and the aligned middle from the level above.
+static void ot_pyramid_range(TimeCurvePyramid* pyr, size_t lo, size_t hi, OT_ValueRange* r) {
+    OT_ControlPoint* knots = pyr->source->knots;
+    while (lo < hi && lo % OT_PYRAMID_FANOUT)
+        ot_value_range_include(r, knots[lo++].value.t);
+    while (hi > lo && hi % OT_PYRAMID_FANOUT)
+        ot_value_range_include(r, knots[--hi].value.t);
+    lo /= OT_PYRAMID_FANOUT;
+    hi /= OT_PYRAMID_FANOUT;
+
+    for (int l = 0; l < pyr->levels && lo < hi; ++l) {
+        OT_ValueRange* level = pyr->ranges + pyr->level_offset[l];
+        bool top = l + 1 == pyr->levels;
+        while (lo < hi && (top || lo % OT_PYRAMID_FANOUT)) {
+            ot_value_range_include(r, level[lo].min);
+            ot_value_range_include(r, level[lo++].max);
+        }
+        while (hi > lo && hi % OT_PYRAMID_FANOUT) {
+            --hi;
+            ot_value_range_include(r, level[hi].min);
+            ot_value_range_include(r, level[hi].max);
         }
+        lo /= OT_PYRAMID_FANOUT;
+        hi /= OT_PYRAMID_FANOUT;
+    }
+}
 
-    // split other into curves where it goes in and out of the domain of self
-    var curves_to_project = std.ArrayList(TimeCurveLinear).init(ALLOCATOR);
-    const self_bounds = self.extents();
-    var last_index: i32 = -10;
-    var current_curve = std.ArrayList(ControlPoint).init(ALLOCATOR);
-    for (other_copy.knots) 
-        |other_knot, index| 
-        {
-            if (
-                    self_bounds[0].time <= other_knot.value 
-                    and other_knot.value <= self_bounds[1].time
-               ) 
-            {
-                if (index != last_index+1) {
-                    // curves of less than one point are trimmed, because they
-                    // have no duration, and therefore are not modelled in our
-                    // system.
-                    if (current_curve.items.len > 1) {
-                        curves_to_project.append(
-                                TimeCurveLinear.init(
-                                    current_curve.items
-                                    ) catch unreachable
-                                ) catch unreachable;
-                    }
-                    current_curve = std.ArrayList(ControlPoint).init(ALLOCATOR);
-                }
-
-                current_curve.append(other_knot) catch unreachable;
-                last_index = @intCast(i32, index);
+// Writes the range of values the curve takes over each of pixels equal
+// slices of [t0, t1): the values at the slice's ends within the curve,
+// and every knot in between. A slice not touching the curve gets NaN.
+// Each slice costs a cursor step to find its knots and O(log n) pyramid
+// entries, however many knots it spans.
+void ot_tcl_pyramid_query(TimeCurvePyramid* pyr, float t0, float t1, int pixels,
+        float* min_out, float* max_out) {
+    if (!pyr || !min_out || !max_out || pixels <= 0)
+        return;
+
+    TimeCurveLinear* tcl = pyr->source;
+    OT_ControlPoint* knots = tcl->knots;
+    int n = (int) cvector_size(knots);
+    float w = (t1 - t0) / (float) pixels;
+    TimeCurveLinearCursor cursor = TimeCurveLinearCursor_default;
+    for (int p = 0; p < pixels; ++p) {
+        float a = t0 + w * (float) p;
+        float b = t0 + w * (float) (p + 1);
+        if (n == 0 || !(b > knots[0].time.t) || !(a <= knots[n - 1].time.t)) {
+            min_out[p] = max_out[p] = NAN;
+            continue;
+        }
+        if (a < knots[0].time.t)
+            a = knots[0].time.t;
+        if (b > knots[n - 1].time.t)
+            b = knots[n - 1].time.t;
+
+        OT_ValueRange r = { INFINITY, -INFINITY };
+        int ia = ot_tcl_cursor_seek(tcl, &cursor, a);
+        if (ia < 0) {
+            // a is the last knot
+            ot_value_range_include(&r, knots[n - 1].value.t);
+        }
+        else {
+            ot_value_range_include(&r, value_at_time_between(a, knots[ia], knots[ia + 1]));
+
+            // knots after a up to b, then the value at b
+            int ib = n - 1;
+            if (b < knots[n - 1].time.t) {
+                ib = ot_tcl_cursor_seek(tcl, &cursor, b);
+                ot_value_range_include(&r, value_at_time_between(b, knots[ib], knots[ib + 1]));
             }
+            ot_pyramid_range(pyr, (size_t) ia + 1, (size_t) ib + 1, &r);
         }
-    if (current_curve.items.len > 1) {
-        curves_to_project.append(
-                TimeCurveLinear.init(current_curve.items) catch unreachable
-                ) catch unreachable;
+        min_out[p] = r.min;
+        max_out[p] = r.max;
     }
+}
 
-    if (curves_to_project.items.len == 0) {
-        return &[_]TimeCurveLinear{};
-    }
 
-    for (curves_to_project.items) 
-        |crv| 
-        {
-            // project each knot
-            for (crv.knots) 
-                |knot, index| 
-                {
-                    // 2. evaluate grows a parameter to treat endpoint as in bounds
-                    // 3. check outside of evaluate if it sits on a knot and use
-                    //    the value rathe rthan computing
-                    // 4. catch the error and call a different function or do a
-                    //    check in that case
-                    const value = self.evaluate(knot.value) catch (
-                            if (self.knots[self.knots.len-1].time == knot.value) 
-                            self.knots[self.knots.len-1].value 
-                            else unreachable
-                            );
-                    crv.knots[index] = .{
-                        .time = knot.time,
-                            // this will error out trying to project the last endpoint
-                            // .value = self.evaluate(knot.value) catch unreachable
-                            .value = value
-                    };
-                }
-        }
+void ot_curve_interface_deinit(CurveInterface* ci) {
+    if (!ci || !ci->alloc)
+        return;
 
-    return curves_to_project.items;
+    ci->alloc->free(ci);
 }
 
-
 CurveInterface* curve_interface_create(CurveAllocator* alloc) {
     if (!alloc)
         return NULL;
-    CurveInterface* ci = (CurveInterface*) malloc(sizeof(CurveInterface));
+    CurveInterface* ci = (CurveInterface*) alloc->malloc(sizeof(CurveInterface));
+    ci->alloc = alloc;
+    ci->deinit = ot_curve_interface_deinit;
     ci->tcl_init_with_knots = ot_tcl_init_with_knots;
     ci->tcl_init_identity = ot_tcl_init_identity;
     ci->tcl_eval = ot_tcl_eval;
     ci->tcl_deinit = ot_tcl_deinit;
     ci->tcl_nearest_smaller_knot_index = ot_tcl_nearest_smaller_knot_index;
+    ci->tcl_eval_cursor = ot_tcl_eval_cursor;
+    ci->tcl_cursor_seek = ot_tcl_cursor_seek;
+    ci->tcl_eval_many = ot_tcl_eval_many;
     ci->tcl_extents = ot_tcl_extents;
+    ci->tcl_update_extents = ot_tcl_update_extents;
+    ci->tcl_update_spacing = ot_tcl_update_spacing;
+    ci->tcl_append_knot = ot_tcl_append_knot;
+    ci->tcl_set_knot = ot_tcl_set_knot;
+    ci->tcc_compile = ot_tcc_compile;
+    ci->tcc_deinit = ot_tcc_deinit;
+    ci->tcc_eval = ot_tcc_eval;
+    ci->tcc_nearest_smaller_knot_index = ot_tcc_nearest_smaller_knot_index;
+    ci->tcl_project_curve = ot_project_curve;
+    ci->tcl_array_deinit = ot_tcl_array_deinit;
+    ci->tcl_as_affine = ot_tcl_as_affine;
+    ci->tcl_project_through_affine = ot_tcl_project_through_affine;
+    ci->tcl_project_affine = ot_tcl_project_affine;
+    ci->tcl_inverse_build = ot_tcl_inverse_build;
+    ci->tcl_inverse_deinit = ot_tcl_inverse_deinit;
+    ci->tcl_inverse_eval = ot_tcl_inverse_eval;
+    ci->tcl_simplify = ot_tcl_simplify;
+    ci->tcb_init_with_segments = ot_tcb_init_with_segments;
+    ci->tcb_deinit = ot_tcb_deinit;
+    ci->tcb_eval = ot_tcb_eval;
+    ci->tcb_nearest_smaller_segment_index = ot_tcb_nearest_smaller_segment_index;
+    ci->tcb_extents = ot_tcb_extents;
+    ci->tcb_linearize = ot_tcb_linearize;
+    ci->tcl_pyramid_build = ot_tcl_pyramid_build;
+    ci->tcl_pyramid_deinit = ot_tcl_pyramid_deinit;
+    ci->tcl_pyramid_update = ot_tcl_pyramid_update;
+    ci->tcl_pyramid_query = ot_tcl_pyramid_query;
     return ci;
 }
 
@@ -746,6 +3784,180 @@ float findU(float x, float p0, float p1, float p2, float p3)
     return _findU(x - p0, p1 - p0, p2 - p0, p3 - p0);
 }
 
+// Seeds findU_n: the segment's control points relative to p0, and the
+// curve sampled at OT_FINDU_TABLE_SIZE + 1 evenly spaced parameters.
+void findU_table_init(OT_FindUTable* table, float p0, float p1, float p2, float p3)
+{
+    table->p0 = p0;
+    table->p1 = p1 - p0;
+    table->p2 = p2 - p0;
+    table->p3 = p3 - p0;
+    for (int i = 0; i <= OT_FINDU_TABLE_SIZE; ++i)
+        table->x[i] = _bezier0((float) i / OT_FINDU_TABLE_SIZE, 
+                table->p1, table->p2, table->p3);
+}
+
+#if defined(OT_SIMD_SSE2)
+static inline __m128 ot_select_ps(__m128 mask, __m128 a, __m128 b) {
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+static inline __m128 ot_bezier0_ps(__m128 z, __m128 p2, __m128 p3, __m128 p4) {
+    const __m128 one = _mm_set1_ps(1.f);
+    const __m128 three = _mm_set1_ps(3.f);
+    __m128 z2 = _mm_mul_ps(z, z);
+    __m128 z3 = _mm_mul_ps(z2, z);
+    __m128 zmo = _mm_sub_ps(z, one);
+    __m128 zmo2 = _mm_mul_ps(zmo, zmo);
+    return _mm_add_ps(
+            _mm_sub_ps(_mm_mul_ps(p4, z3), 
+                _mm_mul_ps(p3, _mm_mul_ps(_mm_mul_ps(three, z2), zmo))),
+            _mm_mul_ps(p2, _mm_mul_ps(_mm_mul_ps(three, z), zmo2)));
+}
+#elif defined(OT_SIMD_NEON) && defined(__aarch64__)
+static inline float32x4_t ot_bezier0_f32(float32x4_t z, 
+        float32x4_t p2, float32x4_t p3, float32x4_t p4) {
+    const float32x4_t one = vdupq_n_f32(1.f);
+    const float32x4_t three = vdupq_n_f32(3.f);
+    float32x4_t z2 = vmulq_f32(z, z);
+    float32x4_t z3 = vmulq_f32(z2, z);
+    float32x4_t zmo = vsubq_f32(z, one);
+    float32x4_t zmo2 = vmulq_f32(zmo, zmo);
+    return vaddq_f32(
+            vsubq_f32(vmulq_f32(p4, z3), 
+                vmulq_f32(p3, vmulq_f32(vmulq_f32(three, z2), zmo))),
+            vmulq_f32(p2, vmulq_f32(vmulq_f32(three, z), zmo2)));
+}
+#endif
+
+//
+// findU for count values of x against one segment, four at a time. Each
+// lane starts from the table entries bracketing its x rather than [0, 1],
+// then runs the same Pegasus iteration as _findU with the lanes that have
+// converged masked off, until every lane has or MAX_ITERATIONS is reached.
+// Lanes stop on the same FLT_EPSILON * 2 bracket as findU, so results
+// agree with it to that tolerance, except where B is nearly flat in u:
+// there many u solve x equally well, and the two may settle on different
+// ones.
+//
+void findU_n(OT_FindUTable* table, float* x_in, float* u_out, size_t count)
+{
+    const float MAX_ABS_ERROR = FLT_EPSILON * 2.0f;
+    const int MAX_ITERATIONS = 45;
+    size_t i = 0;
+
+#if defined(OT_SIMD_SSE2)
+    const __m128 p1 = _mm_set1_ps(table->p1);
+    const __m128 p2 = _mm_set1_ps(table->p2);
+    const __m128 p3 = _mm_set1_ps(table->p3);
+    const __m128 p0 = _mm_set1_ps(table->p0);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.f);
+    const __m128 sign = _mm_set1_ps(-0.f);
+    const __m128 max_err = _mm_set1_ps(MAX_ABS_ERROR);
+    const __m128 step = _mm_set1_ps(1.f / OT_FINDU_TABLE_SIZE);
+    for (; i + 4 <= count; i += 4) {
+        __m128 x = _mm_sub_ps(_mm_loadu_ps(x_in + i), p0);
+
+        // bracket: k = number of interior samples at or below x
+        __m128i k = _mm_setzero_si128();
+        for (int j = 1; j < OT_FINDU_TABLE_SIZE; ++j)
+            k = _mm_sub_epi32(k, _mm_castps_si128(
+                        _mm_cmple_ps(_mm_set1_ps(table->x[j]), x)));
+        int ks[4];
+        _mm_storeu_si128((__m128i*) ks, k);
+        __m128 u1 = _mm_mul_ps(_mm_cvtepi32_ps(k), step);
+        __m128 u2 = _mm_add_ps(u1, step);
+        __m128 x1 = _mm_sub_ps(_mm_setr_ps(table->x[ks[0]], table->x[ks[1]], 
+                    table->x[ks[2]], table->x[ks[3]]), x);
+        __m128 x2 = _mm_sub_ps(_mm_setr_ps(table->x[ks[0] + 1], table->x[ks[1] + 1], 
+                    table->x[ks[2] + 1], table->x[ks[3] + 1]), x);
+
+        // lanes on a sample are done; the rest bracket a sign change
+        __m128 active = _mm_and_ps(_mm_cmpneq_ps(x1, zero), _mm_cmpneq_ps(x2, zero));
+        for (int it = 0; it < MAX_ITERATIONS && _mm_movemask_ps(active); ++it) {
+            __m128 u3 = _mm_sub_ps(u2, _mm_mul_ps(x2, 
+                        _mm_div_ps(_mm_sub_ps(u2, u1), _mm_sub_ps(x2, x1))));
+            __m128 x3 = _mm_sub_ps(ot_bezier0_ps(u3, p1, p2, p3), x);
+
+            __m128 flip = _mm_cmple_ps(_mm_mul_ps(x2, x3), zero);
+            __m128 nu1 = ot_select_ps(flip, u2, u1);
+            __m128 nx1 = ot_select_ps(flip, x2, 
+                    _mm_div_ps(_mm_mul_ps(x1, x2), _mm_add_ps(x2, x3)));
+            u1 = ot_select_ps(active, nu1, u1);
+            x1 = ot_select_ps(active, nx1, x1);
+            u2 = ot_select_ps(active, u3, u2);
+            x2 = ot_select_ps(active, x3, x2);
+
+            __m128 width = _mm_andnot_ps(sign, _mm_sub_ps(u2, u1));
+            active = _mm_and_ps(active, _mm_and_ps(
+                        _mm_cmpneq_ps(x3, zero), _mm_cmpgt_ps(width, max_err)));
+        }
+
+        __m128 u = ot_select_ps(
+                _mm_cmplt_ps(_mm_andnot_ps(sign, x1), _mm_andnot_ps(sign, x2)), u1, u2);
+        u = ot_select_ps(_mm_cmpeq_ps(x1, zero), u1, u);
+        u = ot_select_ps(_mm_cmpge_ps(x, _mm_set1_ps(table->p3)), one, u);
+        u = ot_select_ps(_mm_cmple_ps(x, zero), zero, u);
+        _mm_storeu_ps(u_out + i, u);
+    }
+#elif defined(OT_SIMD_NEON) && defined(__aarch64__)
+    const float32x4_t p1 = vdupq_n_f32(table->p1);
+    const float32x4_t p2 = vdupq_n_f32(table->p2);
+    const float32x4_t p3 = vdupq_n_f32(table->p3);
+    const float32x4_t p0 = vdupq_n_f32(table->p0);
+    const float32x4_t zero = vdupq_n_f32(0.f);
+    const float32x4_t one = vdupq_n_f32(1.f);
+    const float32x4_t max_err = vdupq_n_f32(MAX_ABS_ERROR);
+    const float32x4_t step = vdupq_n_f32(1.f / OT_FINDU_TABLE_SIZE);
+    for (; i + 4 <= count; i += 4) {
+        float32x4_t x = vsubq_f32(vld1q_f32(x_in + i), p0);
+
+        uint32x4_t k = vdupq_n_u32(0);
+        for (int j = 1; j < OT_FINDU_TABLE_SIZE; ++j)
+            k = vsubq_u32(k, vcleq_f32(vdupq_n_f32(table->x[j]), x));
+        uint32_t ks[4];
+        vst1q_u32(ks, k);
+        float32x4_t u1 = vmulq_f32(vcvtq_f32_u32(k), step);
+        float32x4_t u2 = vaddq_f32(u1, step);
+        float lo[4] = { table->x[ks[0]], table->x[ks[1]], table->x[ks[2]], table->x[ks[3]] };
+        float hi[4] = { table->x[ks[0] + 1], table->x[ks[1] + 1], 
+            table->x[ks[2] + 1], table->x[ks[3] + 1] };
+        float32x4_t x1 = vsubq_f32(vld1q_f32(lo), x);
+        float32x4_t x2 = vsubq_f32(vld1q_f32(hi), x);
+
+        uint32x4_t active = vandq_u32(vmvnq_u32(vceqq_f32(x1, zero)), 
+                vmvnq_u32(vceqq_f32(x2, zero)));
+        for (int it = 0; it < MAX_ITERATIONS && vmaxvq_u32(active); ++it) {
+            float32x4_t u3 = vsubq_f32(u2, vmulq_f32(x2, 
+                        vdivq_f32(vsubq_f32(u2, u1), vsubq_f32(x2, x1))));
+            float32x4_t x3 = vsubq_f32(ot_bezier0_f32(u3, p1, p2, p3), x);
+
+            uint32x4_t flip = vcleq_f32(vmulq_f32(x2, x3), zero);
+            float32x4_t nu1 = vbslq_f32(flip, u2, u1);
+            float32x4_t nx1 = vbslq_f32(flip, x2, 
+                    vdivq_f32(vmulq_f32(x1, x2), vaddq_f32(x2, x3)));
+            u1 = vbslq_f32(active, nu1, u1);
+            x1 = vbslq_f32(active, nx1, x1);
+            u2 = vbslq_f32(active, u3, u2);
+            x2 = vbslq_f32(active, x3, x2);
+
+            float32x4_t width = vabsq_f32(vsubq_f32(u2, u1));
+            active = vandq_u32(active, vandq_u32(
+                        vmvnq_u32(vceqq_f32(x3, zero)), vcgtq_f32(width, max_err)));
+        }
+
+        float32x4_t u = vbslq_f32(vcltq_f32(vabsq_f32(x1), vabsq_f32(x2)), u1, u2);
+        u = vbslq_f32(vceqq_f32(x1, zero), u1, u);
+        u = vbslq_f32(vcgeq_f32(x, p3), one, u);
+        u = vbslq_f32(vcleq_f32(x, zero), zero, u);
+        vst1q_f32(u_out + i, u);
+    }
+#endif
+    for (; i < count; ++i)
+        u_out[i] = _findU(x_in[i] - table->p0, table->p1, table->p2, table->p3);
+}
+
 
 
 #ifdef TESTING
@@ -757,15 +3969,15 @@ void test_control_points() {
         OT_ControlPoint cp2 = { { 20 }, { -10 } };
         OT_ControlPoint test = {{ 20 }, { 0 } };
         OT_ControlPoint result = OT_add_cp(cp1, cp2);
-        bool success = OT_cp_equal(test, result);
+        bool success = OT_CHECK(OT_cp_equal(test, result));
     }
     {
         // sub
         OT_ControlPoint cp1 = { { 0 }, { 10 } };
         OT_ControlPoint cp2 = { { 20 }, { -10 } };
-        OT_ControlPoint test = {{ -20 }, { 0 } };
-        OT_ControlPoint result = OT_add_cp(cp1, cp2);
-        bool success = OT_cp_equal(test, result);
+        OT_ControlPoint test = {{ -20 }, { 20 } };
+        OT_ControlPoint result = OT_sub_cp(cp1, cp2);
+        bool success = OT_CHECK(OT_cp_equal(test, result));
     }
     {
         // mul 
@@ -773,102 +3985,952 @@ void test_control_points() {
         float scale = -10;
         OT_ControlPoint test = {{ 0 }, { -100 } };
         OT_ControlPoint result = OT_mul_cp(cp1, scale);
-        bool success = OT_cp_equal(test, result);
+        bool success = OT_CHECK(OT_cp_equal(test, result));
     }
     {
         // lerp
         OT_ControlPoint fst = {{ 0 }, { 0 }};
         OT_ControlPoint snd = {{ 1 }, { 1 }};
         bool success;
-        success = OT_lerp_cp(0.00f, fst, snd).value.t == 0.00f;
-        success = OT_lerp_cp(0.25f, fst, snd).value.t == 0.25f;
-        success = OT_lerp_cp(0.50f, fst, snd).value.t == 0.50f;
-        success = OT_lerp_cp(0.75f, fst, snd).value.t == 0.75f;
-        success = OT_lerp_cp(0.00f, fst, snd).time.t == 0.00f;
-        success = OT_lerp_cp(0.25f, fst, snd).time.t == 0.25f;
-        success = OT_lerp_cp(0.50f, fst, snd).time.t == 0.50f;
-        success = OT_lerp_cp(0.75f, fst, snd).time.t == 0.75f;
+        success = OT_CHECK(OT_lerp_cp(0.00f, fst, snd).value.t == 0.00f);
+        success = OT_CHECK(OT_lerp_cp(0.25f, fst, snd).value.t == 0.25f);
+        success = OT_CHECK(OT_lerp_cp(0.50f, fst, snd).value.t == 0.50f);
+        success = OT_CHECK(OT_lerp_cp(0.75f, fst, snd).value.t == 0.75f);
+        success = OT_CHECK(OT_lerp_cp(0.00f, fst, snd).time.t == 0.00f);
+        success = OT_CHECK(OT_lerp_cp(0.25f, fst, snd).time.t == 0.25f);
+        success = OT_CHECK(OT_lerp_cp(0.50f, fst, snd).time.t == 0.50f);
+        success = OT_CHECK(OT_lerp_cp(0.75f, fst, snd).time.t == 0.75f);
     }
     {
         bool success;
-        success = findU(0.f, 0.f, 1.f, 2.f, 3.f) == 0.f;
+        success = OT_CHECK(findU(0.f, 0.f, 1.f, 2.f, 3.f) == 0.f);
         // out of range values are clamped
-        success = findU(-1.f, 0.f, 1.f, 2.f, 3.f) == 0.f;
-        success = findU(1.f, 0.f, 1.f, 2.f, 3.f) == 1.f;
+        success = OT_CHECK(findU(-1.f, 0.f, 1.f, 2.f, 3.f) == 0.f);
+        success = OT_CHECK(findU(4.f, 0.f, 1.f, 2.f, 3.f) == 1.f);
+    }
+    {
+        // batches agree with findU, including the clamped ends
+        OT_FindUTable table;
+        findU_table_init(&table, 1.f, 1.5f, 3.f, 4.f);
+        float x[9] = { 0.f, 1.f, 1.3f, 1.9f, 2.5f, 3.1f, 3.7f, 4.f, 5.f };
+        float u[9];
+        findU_n(&table, x, u, 9);
+        bool success = true;
+        for (int i = 0; i < 9; ++i)
+            success = OT_CHECK(fabsf(u[i] - findU(x[i], 1.f, 1.5f, 3.f, 4.f)) <= FLT_EPSILON * 2.f) && success;
     }
  }
 
-#endif // TESTING
+void test_knot_search() {
+    CurveAllocator alloc = { .malloc = malloc, .free = free };
+    CurveInterface* ci = curve_interface_create(&alloc);
+    OT_ControlPoint knots[5] = {
+        {{ 0 }, { 0 }}, {{ 1 }, { 10 }}, {{ 2 }, { 20 }}, {{ 4 }, { 30 }}, {{ 8 }, { 40 }} };
+    TimeCurveLinear* tcl = ci->tcl_init_with_knots(ci, knots, 5);
+    {
+        bool success = OT_CHECK(ci->tcl_nearest_smaller_knot_index(tcl, -1.f) == -1);
+        success = OT_CHECK(ci->tcl_nearest_smaller_knot_index(tcl, 0.f) == 0);
+        success = OT_CHECK(ci->tcl_nearest_smaller_knot_index(tcl, 1.f) == 1);
+        success = OT_CHECK(ci->tcl_nearest_smaller_knot_index(tcl, 7.9f) == 3);
+        success = OT_CHECK(ci->tcl_nearest_smaller_knot_index(tcl, 8.f) == -1);
+    }
+    {
+        // cursor forward, jump and back
+        TimeCurveLinearCursor cursor = TimeCurveLinearCursor_default;
+        bool success = OT_CHECK(ci->tcl_eval_cursor(ci, tcl, &cursor, 0.5f).val == 5.f);
+        success = OT_CHECK(ci->tcl_eval_cursor(ci, tcl, &cursor, 1.5f).val == 15.f);
+        success = OT_CHECK(cursor.index == 1);
+        success = OT_CHECK(ci->tcl_eval_cursor(ci, tcl, &cursor, 6.f).val == 35.f);
+        success = OT_CHECK(cursor.index == 3);
+        success = OT_CHECK(ci->tcl_eval_cursor(ci, tcl, &cursor, 0.f).val == 0.f);
+        success = OT_CHECK(cursor.index == 0);
+        success = OT_CHECK(ci->tcl_eval_cursor(ci, tcl, &cursor, 9.f).err == EvalOutOfBounds);
+    }
+    {
+        // batched evaluation matches tcl_eval
+        float times[10] = { -1.f, 0.f, 0.25f, 0.5f, 1.f, 3.f, 5.f, 6.f, 7.f, 8.f };
+        float values[10];
+        uint8_t oob[2];
+        bool success = OT_CHECK(ci->tcl_eval_many(ci, tcl, times, 10, values, oob) == 2);
+        success = OT_CHECK(oob[0] == 0x01 && oob[1] == 0x02);
+        for (int i = 0; i < 10; ++i)
+            success = OT_CHECK(values[i] == ci->tcl_eval(ci, tcl, times[i]).val) && success;
+    }
+    {
+        // compiled curves agree with the source curve
+        TimeCurveCompiled* tcc = ci->tcc_compile(ci, tcl);
+        bool success = OT_CHECK(ci->tcc_eval(ci, tcc, 0.5f).val == 5.f);
+        success = OT_CHECK(ci->tcc_eval(ci, tcc, 6.f).val == ci->tcl_eval(ci, tcl, 6.f).val);
+        success = OT_CHECK(ci->tcc_nearest_smaller_knot_index(tcc, 8.f) < 0);
+        success = OT_CHECK(ci->tcc_eval(ci, tcc, -1.f).err == EvalOutOfBounds);
+        ci->tcc_deinit(ci, tcc);
+    }
+    {
+        // a 24/s retime a hundred hours in stays on the source curve
+        OT_ControlPoint late[3] = { 
+            {{ 360000.3f }, { 0 }}, {{ 360001.3f }, { 24 }}, {{ 360002.3f }, { 48 }} };
+        TimeCurveLinear* far = ci->tcl_init_with_knots(ci, late, 3);
+        TimeCurveCompiled* tcc = ci->tcc_compile(ci, far);
+        bool success = true;
+        for (int i = 0; i < 16; ++i) {
+            float t = late[0].time.t + (late[2].time.t - late[0].time.t) * (float) i / 16.f;
+            success = OT_CHECK(fabsf(ci->tcc_eval(ci, tcc, t).val - 
+                        ci->tcl_eval(ci, far, t).val) <= 1e-3f) && success;
+        }
+        ci->tcc_deinit(ci, tcc);
+        ci->tcl_deinit(ci, far);
+    }
+    ci->tcl_deinit(ci, tcl);
+    ci->deinit(ci);
+}
+
+void test_project_curve() {
+    CurveAllocator alloc = { .malloc = malloc, .free = free };
+    CurveInterface* ci = curve_interface_create(&alloc);
+
+    // self doubles times in [0, 4]
+    OT_ControlPoint self_knots[3] = { {{ 0 }, { 0 }}, {{ 2 }, { 4 }}, {{ 4 }, { 8 }} };
+    TimeCurveLinear* self = ci->tcl_init_with_knots(ci, self_knots, 3);
+    {
+        // other runs -2 to 6 over [0, 8], so only [2, 6] projects
+        OT_ControlPoint other_knots[2] = { {{ 0 }, { -2 }}, {{ 8 }, { 6 }} };
+        TimeCurveLinear* other = ci->tcl_init_with_knots(ci, other_knots, 2);
+        TimeCurveLinearArray result = ci->tcl_project_curve(ci, self, other);
+        bool success = OT_CHECK(result.count == 1);
+        success = OT_CHECK(cvector_size(result.curves[0].knots) == 3);
+        success = OT_CHECK(OT_cp_equal(result.curves[0].knots[0], (OT_ControlPoint) {{ 2 }, { 0 }}));
+        success = OT_CHECK(OT_cp_equal(result.curves[0].knots[1], (OT_ControlPoint) {{ 4 }, { 4 }}));
+        success = OT_CHECK(OT_cp_equal(result.curves[0].knots[2], (OT_ControlPoint) {{ 6 }, { 8 }}));
+        ci->tcl_array_deinit(ci, &result);
+        ci->tcl_deinit(ci, other);
+    }
+    {
+        // other leaves and reenters the domain, and ends on its endpoint
+        OT_ControlPoint other_knots[4] = { 
+            {{ 0 }, { 1 }}, {{ 1 }, { 6 }}, {{ 2 }, { 3 }}, {{ 3 }, { 4 }} };
+        TimeCurveLinear* other = ci->tcl_init_with_knots(ci, other_knots, 4);
+        TimeCurveLinearArray result = ci->tcl_project_curve(ci, self, other);
+        bool success = OT_CHECK(result.count == 2);
+        success = OT_CHECK(result.curves[1].knots[cvector_size(result.curves[1].knots) - 1].value.t == 8.f);
+
+        // appending moves the knots out of the shared block
+        OT_ControlPoint* before = result.curves[0].knots;
+        ci->tcl_append_knot(&result.curves[0], (OT_ControlPoint) {{ 10 }, { 0 }});
+        success = OT_CHECK(!result.curves[0].knots_shared && result.curves[0].knots != before);
+        success = OT_CHECK(OT_cp_equal(result.curves[0].knots[0], before[0]));
+        success = OT_CHECK(result.curves[1].knots_shared);
+        ci->tcl_array_deinit(ci, &result);
+        ci->tcl_deinit(ci, other);
+    }
+    {
+        // closed form through a two knot curve
+        OT_ControlPoint other_knots[3] = { {{ 0 }, { 0 }}, {{ 1 }, { 2 }}, {{ 2 }, { 1 }} };
+        TimeCurveLinear* other = ci->tcl_init_with_knots(ci, other_knots, 3);
+        TimeCurveLinear* line = ci->tcl_init_with_knots(ci, self_knots, 2);
+        OT_TimeAffineTransform xform;
+        bool success = OT_CHECK(ci->tcl_as_affine(line, &xform) && xform.s == 2.f && xform.t.t == 0.f);
+        success = OT_CHECK(!ci->tcl_as_affine(self, &xform));
+        TimeCurveLinearArray result = ci->tcl_project_curve(ci, line, other);
+        success = OT_CHECK(result.count == 1 && cvector_size(result.curves[0].knots) == 3);
+        success = OT_CHECK(result.curves[0].knots[1].value.t == 4.f);
+        ci->tcl_append_knot(&result.curves[0], (OT_ControlPoint) {{ 3 }, { 0 }});
+        success = OT_CHECK(cvector_size(result.curves[0].knots) == 4);
+        ci->tcl_array_deinit(ci, &result);
+
+        // affines in place, on either side
+        OT_TimeAffineTransform double_it = { { 1.f }, 2.f };
+        ci->tcl_project_through_affine(&double_it, other);
+        success = OT_CHECK(OT_cp_equal(other->knots[1], (OT_ControlPoint) {{ 1 }, { 5 }}));
+        OT_TimeAffineTransform reverse = { { 2.f }, -1.f };
+        success = OT_CHECK(ci->tcl_project_affine(other, &reverse));
+        success = OT_CHECK(OT_cp_equal(other->knots[0], (OT_ControlPoint) {{ 0 }, { 3 }}));
+        success = OT_CHECK(OT_cp_equal(other->knots[2], (OT_ControlPoint) {{ 2 }, { 1 }}));
+        ci->tcl_deinit(ci, line);
+        ci->tcl_deinit(ci, other);
+    }
+    ci->tcl_deinit(ci, self);
+    ci->deinit(ci);
+}
+
+void test_inverse_curve() {
+    CurveAllocator alloc = { .malloc = malloc, .free = free };
+    CurveInterface* ci = curve_interface_create(&alloc);
+
+    OT_ControlPoint knots[5] = { 
+        {{ 0 }, { 0 }}, {{ 1 }, { 5 }}, {{ 2 }, { 2 }}, {{ 3 }, { 7 }}, {{ 4 }, { 7 }} };
+    TimeCurveLinear* tcl = ci->tcl_init_with_knots(ci, knots, 5);
+    TimeCurveInverse* inv = ci->tcl_inverse_build(ci, tcl);
+    {
+        float times[4];
+        bool success = OT_CHECK(inv->run_count == 4);
+        success = OT_CHECK(ci->tcl_inverse_eval(inv, 3.f, times, 4) == 3);
+        // the turning points are reported once
+        success = OT_CHECK(ci->tcl_inverse_eval(inv, 5.f, times, 4) == 2);
+        success = OT_CHECK(ci->tcl_inverse_eval(inv, 2.f, times, 4) == 2);
+        // the flat run only where it starts
+        success = OT_CHECK(ci->tcl_inverse_eval(inv, 7.f, times, 4) == 1 && times[0] == 3.f);
+        success = OT_CHECK(ci->tcl_inverse_eval(inv, 0.f, times, 4) == 1 && times[0] == 0.f);
+        success = OT_CHECK(ci->tcl_inverse_eval(inv, 8.f, times, 4) == 0);
+        success = OT_CHECK(ci->tcl_inverse_eval(inv, 3.f, NULL, 0) == 3);
+    }
+    {
+        // a run's inverse can be appended to; deinit releases the copy
+        TimeCurveLinear* run = &inv->runs[0].inverse;
+        ci->tcl_append_knot(run, (OT_ControlPoint) {{ 6 }, { 2 }});
+        bool success = OT_CHECK(!run->knots_shared && cvector_size(run->knots) == 3);
+    }
+    ci->tcl_inverse_deinit(ci, inv);
+    ci->tcl_deinit(ci, tcl);
+    ci->deinit(ci);
+}
+
+void test_uniform_spacing() {
+    CurveAllocator alloc = { .malloc = malloc, .free = free };
+    CurveInterface* ci = curve_interface_create(&alloc);
+
+    // frames at 24 fps, which floats cannot space exactly
+    float times[49];
+    for (int i = 0; i < 49; ++i)
+        times[i] = (float) i / 24.f;
+    TimeCurveLinear* tcl = ci->tcl_init_identity(ci, times, 49);
+    {
+        bool success = OT_CHECK(tcl->step > 0.f && tcl->origin == 0.f);
+        for (int i = 0; i < 48; ++i) {
+            success = OT_CHECK(ci->tcl_nearest_smaller_knot_index(tcl, times[i]) == i) && success;
+            success = OT_CHECK(ci->tcl_nearest_smaller_knot_index(tcl, 
+                    nextafterf(times[i + 1], 0.f)) == i) && success;
+        }
+        success = OT_CHECK(ci->tcl_nearest_smaller_knot_index(tcl, 2.f) == -1);
+    }
+    {
+        // the compiled form keeps the grid and finds the same segments
+        TimeCurveCompiled* tcc = ci->tcc_compile(ci, tcl);
+        bool success = OT_CHECK(tcc->inv_step == tcl->inv_step && tcc->origin == tcl->origin);
+        for (int i = 0; i < 48; ++i) {
+            float t = nextafterf(times[i + 1], 0.f);
+            success = OT_CHECK(ci->tcc_nearest_smaller_knot_index(tcc, times[i]) == i) && success;
+            success = OT_CHECK(ci->tcc_nearest_smaller_knot_index(tcc, t) == i) && success;
+        }
+        ci->tcc_deinit(ci, tcc);
+    }
+    {
+        // far cursor jumps land on the computed segment, in both directions
+        TimeCurveLinearCursor cursor = TimeCurveLinearCursor_default;
+        bool success = OT_CHECK(ci->tcl_cursor_seek(tcl, &cursor, times[1]) == 1);
+        success = OT_CHECK(ci->tcl_cursor_seek(tcl, &cursor, times[40]) == 40);
+        success = OT_CHECK(cursor.index == 40);
+        success = OT_CHECK(ci->tcl_cursor_seek(tcl, &cursor, nextafterf(times[47], 0.f)) == 46);
+        success = OT_CHECK(ci->tcl_cursor_seek(tcl, &cursor, times[3]) == 3);
+        success = OT_CHECK(ci->tcl_cursor_seek(tcl, &cursor, times[30]) == 30);
+        for (int i = 0; i < 48; i += 7)
+            success = OT_CHECK(ci->tcl_cursor_seek(tcl, &cursor, times[47 - i]) == 47 - i) && success;
+    }
+    {
+        // appending on the grid keeps it, off the grid drops it
+        ci->tcl_append_knot(tcl, (OT_ControlPoint) {{ 49.f / 24.f }, { 0 }});
+        bool success = OT_CHECK(tcl->step > 0.f);
+        ci->tcl_append_knot(tcl, (OT_ControlPoint) {{ 3.f }, { 0 }});
+        success = OT_CHECK(tcl->step == 0.f);
+        success = OT_CHECK(ci->tcl_nearest_smaller_knot_index(tcl, 2.5f) == 49);
+    }
+    ci->tcl_deinit(ci, tcl);
+    ci->deinit(ci);
+}
+
+void test_curve_pyramid() {
+    CurveAllocator alloc = { .malloc = malloc, .free = free };
+    CurveInterface* ci = curve_interface_create(&alloc);
+
+    // a sawtooth from 0 to 9 every ten knots
+    OT_ControlPoint knots[100];
+    for (int i = 0; i < 100; ++i)
+        knots[i] = (OT_ControlPoint) {{ (float) i }, { (float) (i % 10) }};
+    TimeCurveLinear* tcl = ci->tcl_init_with_knots(ci, knots, 100);
+    TimeCurvePyramid* pyr = ci->tcl_pyramid_build(ci, tcl);
+    float mn[4], mx[4];
+    {
+        bool success = OT_CHECK(pyr->levels == 3);
+        ci->tcl_pyramid_query(pyr, 0.f, 99.f, 3, mn, mx);
+        for (int p = 0; p < 3; ++p)
+            success = OT_CHECK(mn[p] == 0.f && mx[p] == 9.f);
+    }
+    {
+        // zoomed in, pixels see the values at their ends
+        ci->tcl_pyramid_query(pyr, 0.25f, 0.75f, 2, mn, mx);
+        bool success = OT_CHECK(mn[0] == 0.25f && mx[0] == 0.5f);
+        success = OT_CHECK(mn[1] == 0.5f && mx[1] == 0.75f);
+
+        // off the curve
+        ci->tcl_pyramid_query(pyr, -2.f, 0.f, 1, mn, mx);
+        success = OT_CHECK(isnan(mn[0]) && isnan(mx[0]));
+    }
+    {
+        ci->tcl_set_knot(tcl, 50, (OT_ControlPoint) {{ 50.f }, { 100.f }});
+        bool success = OT_CHECK(ci->tcl_pyramid_update(ci, pyr, 50, 50));
+        ci->tcl_pyramid_query(pyr, 0.f, 99.f, 3, mn, mx);
+        success = OT_CHECK(mx[0] == 9.f && mx[1] == 100.f && mx[2] == 9.f);
+
+        // a new knot resizes the levels
+        ci->tcl_append_knot(tcl, (OT_ControlPoint) {{ 100.f }, { -1.f }});
+        success = OT_CHECK(ci->tcl_pyramid_update(ci, pyr, 100, 100));
+        ci->tcl_pyramid_query(pyr, 0.f, 100.f, 1, mn, mx);
+        success = OT_CHECK(pyr->knot_count == 101 && mn[0] == -1.f && mx[0] == 100.f);
+    }
+    {
+        // growing a knot at a time matches a pyramid built from scratch,
+        // and seldom moves the levels
+        int moves = 0;
+        bool success = true;
+        for (int i = 101; i < 1200; ++i) {
+            OT_ValueRange* before = pyr->ranges;
+            ci->tcl_append_knot(tcl, (OT_ControlPoint) {{ (float) i }, { (float) ((i * 7) % 23) }});
+            success = OT_CHECK(ci->tcl_pyramid_update(ci, pyr, i, i)) && success;
+            moves += pyr->ranges != before;
+        }
+        TimeCurvePyramid* fresh = ci->tcl_pyramid_build(ci, tcl);
+        success = OT_CHECK(pyr->levels == fresh->levels && moves < 12);
+        for (int l = 0; l < fresh->levels; ++l) {
+            success = OT_CHECK(pyr->level_count[l] == fresh->level_count[l]) && success;
+            for (size_t j = 0; j < fresh->level_count[l]; ++j) {
+                OT_ValueRange a = pyr->ranges[pyr->level_offset[l] + j];
+                OT_ValueRange b = fresh->ranges[fresh->level_offset[l] + j];
+                success = OT_CHECK(a.min == b.min && a.max == b.max) && success;
+            }
+        }
+        ci->tcl_pyramid_deinit(ci, fresh);
+
+        // dropping the tail refills only what covered it
+        for (int i = 0; i < 1100; ++i)
+            cvector_pop_back(tcl->knots);
+        ci->tcl_update_extents(tcl);
+        success = OT_CHECK(ci->tcl_pyramid_update(ci, pyr, 0, -1));
+        ci->tcl_pyramid_query(pyr, 0.f, 99.f, 1, mn, mx);
+        success = OT_CHECK(pyr->knot_count == 100 && pyr->levels == 3 && mx[0] == 100.f);
+        success = OT_CHECK(pyr->ranges[pyr->level_offset[2]].min == 0.f);
+    }
+    ci->tcl_pyramid_deinit(ci, pyr);
+    ci->tcl_deinit(ci, tcl);
+    ci->deinit(ci);
+}
+
+void test_bezier_curve() {
+    CurveAllocator alloc = { .malloc = malloc, .free = free };
+    CurveInterface* ci = curve_interface_create(&alloc);
+
+    // a straight line, then an overshoot that settles back to 3
+    TimeCurveBezierSegment segments[2] = {
+        { { {{ 0 }, { 0 }}, {{ 1 }, { 1 }}, {{ 2 }, { 2 }}, {{ 3 }, { 3 }} } },
+        { { {{ 3 }, { 3 }}, {{ 4 }, { 6 }}, {{ 5 }, { 6 }}, {{ 6 }, { 3 }} } } };
+    TimeCurveBezier* tcb = ci->tcb_init_with_segments(ci, segments, 2);
+    {
+        bool success = OT_CHECK(ci->tcb_nearest_smaller_segment_index(tcb, 2.9f) == 0);
+        success = OT_CHECK(ci->tcb_nearest_smaller_segment_index(tcb, 3.f) == 1);
+        success = OT_CHECK(fabsf(ci->tcb_eval(ci, tcb, 1.5f).val - 1.5f) < 1e-5f);
+        success = OT_CHECK(ci->tcb_eval(ci, tcb, 3.f).val == 3.f);
+        success = OT_CHECK(fabsf(ci->tcb_eval(ci, tcb, 4.5f).val - 5.25f) < 1e-5f);
+        success = OT_CHECK(ci->tcb_eval(ci, tcb, 6.f).err == EvalOutOfBounds);
+        success = OT_CHECK(ci->tcb_eval(ci, tcb, -1.f).err == EvalOutOfBounds);
+    }
+    {
+        // the overshoot peaks between the control points
+        OT_CurveExtents e = ci->tcb_extents(tcb);
+        bool success = OT_CHECK(e.min.time.t == 0.f && e.max.time.t == 6.f);
+        success = OT_CHECK(e.min.value.t == 0.f && fabsf(e.max.value.t - 5.25f) < 1e-5f);
+    }
+    {
+        // the straight segment needs no extra knots; the overshoot does
+        TimeCurveLinear* coarse = ci->tcb_linearize(ci, tcb, 0.01f);
+        size_t sz = cvector_size(coarse->knots);
+        bool success = OT_CHECK(sz > 3 && coarse->knots[1].time.t == 3.f);
+        success = OT_CHECK(fabsf(ci->tcl_eval(ci, coarse, 4.5f).val - 5.25f) <= 0.01f);
+        // cached, and shared with coarser requests
+        success = OT_CHECK(ci->tcb_linearize(ci, tcb, 0.01f) == coarse);
+        success = OT_CHECK(ci->tcb_linearize(ci, tcb, 0.5f) == coarse);
+        TimeCurveLinear* fine = ci->tcb_linearize(ci, tcb, 0.001f);
+        success = OT_CHECK(fine != coarse && cvector_size(fine->knots) > sz);
+    }
+    ci->tcb_deinit(ci, tcb);
+
+    // time stalls mid-segment while the value swings, close to a cusp
+    TimeCurveBezierSegment cusp =
+        { { {{ 0 }, { 0 }}, {{ 1 }, { 40 }}, {{ 1 }, { -40 }}, {{ 2 }, { 0 }} } };
+    tcb = ci->tcb_init_with_segments(ci, &cusp, 1);
+    {
+        const float tolerance = 0.01f;
+        TimeCurveLinear* tcl = ci->tcb_linearize(ci, tcb, tolerance);
+        bool success = OT_CHECK(tcl != NULL);
+        float err = 0.f;
+        for (int i = 1; i < 20000; ++i) {
+            float u = (float) i / 20000.f;
+            float t = _bezier0(u, 1.f, 1.f, 2.f);
+            float v = _bezier0(u, 40.f, -40.f, 0.f);
+            EvalFloatResult r = ci->tcl_eval(ci, tcl, t);
+            if (r.err == EvalOK && fabsf(r.val - v) > err)
+                err = fabsf(r.val - v);
+        }
+        success = OT_CHECK(err <= tolerance);
+    }
+    ci->tcb_deinit(ci, tcb);
+    ci->deinit(ci);
+}
+
+void test_extents() {
+    CurveAllocator alloc = { .malloc = malloc, .free = free };
+    CurveInterface* ci = curve_interface_create(&alloc);
+
+    OT_ControlPoint knots[3] = { {{ 0 }, { 4 }}, {{ 1 }, { -2 }}, {{ 2 }, { 3 }} };
+    TimeCurveLinear* tcl = ci->tcl_init_with_knots(ci, knots, 3);
+    {
+        OT_CurveExtents e = ci->tcl_extents(tcl);
+        bool success = OT_CHECK(OT_cp_equal(e.min, (OT_ControlPoint) {{ 0 }, { -2 }}));
+        success = OT_CHECK(OT_cp_equal(e.max, (OT_ControlPoint) {{ 2 }, { 4 }}));
+    }
+    {
+        // appending and editing grow the box in place
+        ci->tcl_append_knot(tcl, (OT_ControlPoint) {{ 3 }, { 9 }});
+        ci->tcl_set_knot(tcl, 1, (OT_ControlPoint) {{ 1 }, { -5 }});
+        OT_CurveExtents e = ci->tcl_extents(tcl);
+        bool success = OT_CHECK(!tcl->extents_stale);
+        success = OT_CHECK(OT_cp_equal(e.min, (OT_ControlPoint) {{ 0 }, { -5 }}));
+        success = OT_CHECK(OT_cp_equal(e.max, (OT_ControlPoint) {{ 3 }, { 9 }}));
+    }
+    {
+        // pulling a knot in from an edge shrinks it
+        ci->tcl_set_knot(tcl, 1, (OT_ControlPoint) {{ 1 }, { 1 }});
+        bool success = OT_CHECK(tcl->extents_stale);
+        OT_CurveExtents e = ci->tcl_extents(tcl);
+        success = OT_CHECK(e.min.value.t == 1.f && !tcl->extents_stale);
+    }
+    {
+        // affine projections transform the box with the knots
+        OT_TimeAffineTransform flip = { { 1.f }, -1.f };
+        ci->tcl_project_through_affine(&flip, tcl);
+        OT_CurveExtents e = ci->tcl_extents(tcl);
+        bool success = OT_CHECK(e.min.value.t == -8.f && e.max.value.t == 0.f);
+    }
+    ci->tcl_deinit(ci, tcl);
+    ci->deinit(ci);
+}
+
+void test_simplify() {
+    CurveAllocator alloc = { .malloc = malloc, .free = free };
+    CurveInterface* ci = curve_interface_create(&alloc);
+
+    // a ramp with a little jitter, then a hold
+    OT_ControlPoint knots[8] = { 
+        {{ 0 }, { 0 }}, {{ 1 }, { 1.01f }}, {{ 2 }, { 1.99f }}, {{ 3 }, { 3 }}, 
+        {{ 4 }, { 4 }}, {{ 5 }, { 4 }}, {{ 6 }, { 4.01f }}, {{ 7 }, { 4 }} };
+    TimeCurveLinear* tcl = ci->tcl_init_with_knots(ci, knots, 8);
+    {
+        float err = -1.f;
+        TimeCurveLinear* simple = ci->tcl_simplify(ci, tcl, 0.02f, &err);
+        bool success = OT_CHECK(cvector_size(simple->knots) == 3);
+        success = OT_CHECK(OT_cp_equal(simple->knots[1], knots[4]));
+        success = OT_CHECK(err > 0.f && err <= 0.02f);
+        ci->tcl_deinit(ci, simple);
+    }
+    {
+        // without a tolerance every knot here is needed
+        float err = -1.f;
+        TimeCurveLinear* simple = ci->tcl_simplify(ci, tcl, 0.f, &err);
+        bool success = OT_CHECK(cvector_size(simple->knots) == 8 && err == 0.f);
+        ci->tcl_deinit(ci, simple);
+    }
+    ci->tcl_deinit(ci, tcl);
+    ci->deinit(ci);
+}
+
+#endif // TESTING
+
+#endif // IMPL_OPENTIME_CURVE
+
+
+//------- opentimeline.h starts here
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// An id packs a slot index with the generation of the slot, which
+// changes each time the slot is deleted, so that stale ids are caught.
+// A slot whose generation would wrap is retired instead of reused, so an
+// id never comes back to life.
+typedef struct { uint32_t id; } IntervalOidId;
+const IntervalOidId IntervalOidId_default = { 0 };
+
+#define OT_OID_INDEX_BITS 24
+#define OT_OID_INDEX_MASK ((1u << OT_OID_INDEX_BITS) - 1)
+#define OT_OID_GENERATION_MASK 0xffu
+#define OT_OID_INDEX(id) ((id) & OT_OID_INDEX_MASK)
+#define OT_OID_GENERATION(id) ((id) >> OT_OID_INDEX_BITS)
+struct TimelineTopologyInterface;
+typedef struct TimelineTopologyInterface TimelineTopologyInterface;
+
+typedef struct {
+    IntervalOidId self;
+    IntervalOidId seq;
+    IntervalOidId sync;
+    OT_TimeAffineTransform basis;
+    bool reset_transform;
+    OT_TimeInterval bounds;
+    //OT_TImeCurve mapping;
+} IntervalOid;
+const IntervalOid IntervalOid_default = {{0}, {0}, {0},
+    { {0}, 1.f }, false,
+    {{0}, {INFINITY}}};
+
+struct TimelineTopologyDetail;
+typedef struct TimelineTopologyDetail TimelineTopologyDetail;
+
+// Where each oid sits on the global timeline, indexed by oid index.
+// transforms map an oid's local time to global time, and bounds are its
+// bounds in global time. Oids not reachable from the root are not
+// reached and their entries are unspecified.
+//
+// After a reflatten, changed lists the indices of the oids whose entries
+// changed, including those no longer reached; after a flatten, rebuilt
+// is set instead and every entry is new.
+typedef struct {
+    OT_TimeAffineTransform* transforms;
+    OT_TimeInterval* bounds;
+    uint8_t* reached;
+    int count;
+    uint32_t* changed;
+    int changed_count;
+    bool rebuilt;
+} TimelineFlatCache;
+
+// A leaf oid found by an active clip query, with the queried time in its
+// local time.
+typedef struct {
+    IntervalOidId oid;
+    OT_seconds local;
+} TimelineActiveClip;
+
+struct TimelineTopologyInterface {
+    IntervalOid timeline_root;
+
+    void (*deinit)(TimelineTopologyInterface* self);
+
+    IntervalOidId (*new_oid)(TimelineTopologyInterface* self);
+    bool (*delete_oid)(TimelineTopologyInterface* self, IntervalOidId);
+    IntervalOid* (*get_oid)(TimelineTopologyInterface* self, IntervalOidId);
+    
+    void (*add_sync)(TimelineTopologyInterface* self, IntervalOidId parent, IntervalOidId);
+    void (*add_seq)(TimelineTopologyInterface* self, IntervalOidId parent, IntervalOidId);
+    void (*add_syncs)(TimelineTopologyInterface* self, IntervalOidId parent, 
+            IntervalOidId* first, IntervalOidId* last);
+    void (*add_seqs)(TimelineTopologyInterface* self, IntervalOidId parent, 
+            IntervalOidId* first, IntervalOidId* last);
+
+    void (*set_basis)(TimelineTopologyInterface* self, IntervalOidId, OT_TimeAffineTransform);
+    void (*set_bounds)(TimelineTopologyInterface* self, IntervalOidId, OT_TimeInterval);
+    void (*set_reset_transform)(TimelineTopologyInterface* self, IntervalOidId, bool);
+
+    const TimelineFlatCache* (*flatten)(TimelineTopologyInterface* self);
+    const TimelineFlatCache* (*reflatten)(TimelineTopologyInterface* self, 
+            OT_TimeInterval* changed_out);
+
+    bool (*build_active_index)(TimelineTopologyInterface* self);
+    size_t (*active_at)(TimelineTopologyInterface* self, OT_seconds t, 
+            TimelineActiveClip* out, size_t capacity);
+    size_t (*active_in)(TimelineTopologyInterface* self, OT_TimeInterval range, 
+            TimelineActiveClip* out, size_t capacity);
+    
+    TimelineTopologyDetail* detail;
+};
+
+typedef struct {
+    void* (*malloc)(size_t);
+    void (*free)(void*);
+} TimelineAllocator;
+
+// IntervalOids are stored in pages of OT_TOPO_PAGE_SIZE that are never
+// moved, so a pointer from get_oid stays valid as the topology grows.
+// initial_capacity only sizes the first allocation; new_oid adds pages
+// as they are needed.
+#ifndef OT_TOPO_PAGE_SHIFT
+#define OT_TOPO_PAGE_SHIFT 10
+#endif
+#define OT_TOPO_PAGE_SIZE (1 << OT_TOPO_PAGE_SHIFT)
+#define OT_TOPO_PAGE_MASK (OT_TOPO_PAGE_SIZE - 1)
+
+TimelineTopologyInterface*
+timeline_topology_create(
+        int initial_capacity,
+        TimelineAllocator*);
+
+#define OPENTIMELINE_IMPL
+#ifdef OPENTIMELINE_IMPL
+
+#include <stdlib.h>
+
+// A page of oids. Deleted slots form an intrusive list through their seq
+// links, with their next generation kept in sync; free_head is the
+// first, or OT_TOPO_PAGE_SIZE when the page has none.
+typedef struct {
+    IntervalOid* oids;
+    uint32_t free_head;
+} TimelineTopologyPage;
+
+// self.id of a deleted slot; no live id can equal it
+#define OT_OID_FREE 0xffffffffu
+
+// A chain of siblings waiting to be flattened, starting at first with
+// the given slot. A partial chain stops at the first sibling after first
+// that is already in place.
+typedef struct {
+    IntervalOidId first;
+    uint32_t parent;
+    float slot;
+    bool seq;
+    bool partial;
+} TopoFlattenFrame;
+
+// Why an oid must be placed again.
+#define TOPO_DIRTY_SELF 1
+#define TOPO_DIRTY_LINKS 2
+#define TOPO_DIRTY_DELETED 4
+
+typedef struct {
+    uint32_t depth;
+    float slot;
+    uint32_t index;
+} TopoDirtyEntry;
+
+struct TimelineTopologyDetail {
+    TimelineAllocator* alloc;
+    TimelineTopologyPage* pages;
+    uint64_t* free_pages;
+    int free_word;
+    int page_count;
+    int page_capacity;
+    int next_available;
+
+    // The flat cache and the context each oid was placed in, one entry
+    // per oid index, sharing flat_block. While flattened is set, edits
+    // are recorded in dirty_list and orphans for topo_reflatten.
+    TimelineFlatCache flat;
+    TopoFlattenFrame* frames;
+    uint32_t* parents;
+    float* slots;
+    uint32_t* stamps;
+    uint32_t* listed;
+    uint32_t* depths;
+    uint8_t* kinds;
+    uint8_t* dirty;
+    void* flat_block;
+    int flat_capacity;
+    bool flattened;
+    uint32_t walk;
+    uint32_t pass;
+    TopoDirtyEntry* dirty_list;
+    int dirty_count;
+    int dirty_capacity;
+    IntervalOidId* orphans;
+    int orphan_count;
+    int orphan_capacity;
+    OT_TimeInterval vacated;
+
+    // The active clip index, kept in step with the flat cache once built.
+    // active_flags shares flat_block.
+    bool active_built;
+    OpenTimeAllocator active_alloc;
+    OT_IntervalIndex active;
+    uint8_t* active_flags;
+    uint32_t* active_delta;
+    int active_delta_count;
+    int active_delta_capacity;
+};
+
+static inline IntervalOid* topo_oid(TimelineTopologyDetail* detail, uint32_t id) {
+    uint32_t index = OT_OID_INDEX(id);
+    return &detail->pages[index >> OT_TOPO_PAGE_SHIFT].oids[index & OT_TOPO_PAGE_MASK];
+}
+
+// True when id names a slot that has not been deleted since it was
+// handed out.
+static inline bool topo_live(TimelineTopologyDetail* detail, uint32_t id) {
+    return OT_OID_INDEX(id) < (uint32_t) detail->next_available &&
+        topo_oid(detail, id)->self.id == id;
+}
+
+static inline int topo_ctz64(uint64_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(x);
+#else
+    int n = 0;
+    while (!(x & 1)) {
+        x >>= 1;
+        ++n;
+    }
+    return n;
+#endif
+}
+
+// The lowest page with a deleted slot, or -1. No word of the bitmap
+// below free_word has a bit set.
+static int topo_lowest_free_page(TimelineTopologyDetail* detail) {
+    int words = (detail->page_count + 63) / 64;
+    for (; detail->free_word < words; ++detail->free_word) {
+        uint64_t bits = detail->free_pages[detail->free_word];
+        if (bits)
+            return detail->free_word * 64 + topo_ctz64(bits);
+    }
+    return -1;
+}
+
+// Appends a page of default oids. Only the page table and its bitmap are
+// ever reallocated, and they double, so adding pages is amortized O(1).
+static bool topo_add_page(TimelineTopologyDetail* detail) {
+    TimelineAllocator* alloc = detail->alloc;
+    if (detail->page_count == detail->page_capacity) {
+        int capacity = detail->page_capacity ? detail->page_capacity * 2 : 64;
+        TimelineTopologyPage* pages = 
+            (TimelineTopologyPage*) alloc->malloc(sizeof(TimelineTopologyPage) * capacity);
+        uint64_t* free_pages = (uint64_t*) alloc->malloc(sizeof(uint64_t) * (capacity / 64));
+        if (!pages || !free_pages) {
+            if (pages)
+                alloc->free(pages);
+            if (free_pages)
+                alloc->free(free_pages);
+            return false;
+        }
+        memset(free_pages, 0, sizeof(uint64_t) * (capacity / 64));
+        if (detail->pages) {
+            memcpy(pages, detail->pages, sizeof(TimelineTopologyPage) * detail->page_count);
+            memcpy(free_pages, detail->free_pages, sizeof(uint64_t) * (detail->page_capacity / 64));
+            alloc->free(detail->pages);
+            alloc->free(detail->free_pages);
+        }
+        detail->pages = pages;
+        detail->free_pages = free_pages;
+        detail->page_capacity = capacity;
+    }
+
+    IntervalOid* oids = (IntervalOid*) alloc->malloc(sizeof(IntervalOid) * OT_TOPO_PAGE_SIZE);
+    if (!oids)
+        return false;
+
+    uint32_t base = (uint32_t) detail->page_count << OT_TOPO_PAGE_SHIFT;
+    for (int i = 0; i < OT_TOPO_PAGE_SIZE; ++i) {
+        oids[i] = IntervalOid_default;
+        oids[i].self.id = base + i;
+    }
+    detail->pages[detail->page_count].oids = oids;
+    detail->pages[detail->page_count].free_head = OT_TOPO_PAGE_SIZE;
+    ++detail->page_count;
+    return true;
+}
+
+// Sizes the flattening state for every slot handed out so far, and the
+// frame stack for one more. The arrays share one allocation, which grows
+// by doubling and carries the state of existing oids along.
+static bool topo_reserve_flat(TimelineTopologyDetail* detail) {
+    int count = detail->next_available + 1;
+    if (count <= detail->flat_capacity)
+        return true;
+
+    int capacity = detail->flat_capacity ? detail->flat_capacity : OT_TOPO_PAGE_SIZE;
+    while (capacity < count)
+        capacity *= 2;
+
+    size_t per_oid = sizeof(OT_TimeAffineTransform) + sizeof(OT_TimeInterval) + 
+        sizeof(TopoFlattenFrame) + sizeof(uint32_t) * 5 + sizeof(float) + sizeof(uint8_t) * 4;
+    char* block = (char*) detail->alloc->malloc(per_oid * (size_t) capacity);
+    if (!block)
+        return false;
+    memset(block, 0, per_oid * (size_t) capacity);
+
+    TimelineTopologyDetail old = *detail;
+    int n = old.flat_capacity;
+    detail->flat_block = block;
+#define TOPO_CARVE(member, type) \
+    if (n) memcpy(block, old.member, sizeof(type) * n); \
+    detail->member = (type*) block; \
+    block += sizeof(type) * capacity;
+    TOPO_CARVE(flat.transforms, OT_TimeAffineTransform)
+    TOPO_CARVE(flat.bounds, OT_TimeInterval)
+    TOPO_CARVE(frames, TopoFlattenFrame)
+    TOPO_CARVE(flat.changed, uint32_t)
+    TOPO_CARVE(parents, uint32_t)
+    TOPO_CARVE(stamps, uint32_t)
+    TOPO_CARVE(listed, uint32_t)
+    TOPO_CARVE(depths, uint32_t)
+    TOPO_CARVE(slots, float)
+    TOPO_CARVE(flat.reached, uint8_t)
+    TOPO_CARVE(kinds, uint8_t)
+    TOPO_CARVE(dirty, uint8_t)
+    TOPO_CARVE(active_flags, uint8_t)
+#undef TOPO_CARVE
+    if (old.flat_block)
+        detail->alloc->free(old.flat_block);
+    detail->flat_capacity = capacity;
+    return true;
+}
+
+// Doubles a list's storage, giving up on incremental flattening if it
+// cannot, so that the next reflatten starts over.
+static bool topo_grow_list(TimelineTopologyDetail* detail, void** items, 
+        int* capacity, size_t item_size) {
+    int grown = *capacity ? *capacity * 2 : 64;
+    void* list = detail->alloc->malloc(item_size * grown);
+    if (!list) {
+        detail->flattened = false;
+        return false;
+    }
+    if (*items) {
+        memcpy(list, *items, item_size * *capacity);
+        detail->alloc->free(*items);
+    }
+    *items = list;
+    *capacity = grown;
+    return true;
+}
+
+// Records that the oid at index must be placed again.
+static void topo_mark_dirty(TimelineTopologyDetail* detail, uint32_t index, uint8_t why) {
+    if (!detail->flattened)
+        return;
+    if (!topo_reserve_flat(detail)) {
+        detail->flattened = false;
+        return;
+    }
+
+    if (!detail->dirty[index]) {
+        if (detail->dirty_count == detail->dirty_capacity && 
+                !topo_grow_list(detail, (void**) &detail->dirty_list, 
+                    &detail->dirty_capacity, sizeof(TopoDirtyEntry)))
+            return;
+        detail->dirty_list[detail->dirty_count++] = (TopoDirtyEntry) { 0, 0.f, index };
+    }
+    detail->dirty[index] |= why;
+}
+
+// Records a link that was replaced; unless its target is linked again,
+// the target and everything after and below it leave the timeline.
+static void topo_mark_orphan(TimelineTopologyDetail* detail, IntervalOidId oid) {
+    if (!detail->flattened || OT_OID_INDEX(oid.id) == 0)
+        return;
+
+    if (detail->orphan_count == detail->orphan_capacity && 
+            !topo_grow_list(detail, (void**) &detail->orphans, 
+                &detail->orphan_capacity, sizeof(IntervalOidId)))
+        return;
+    detail->orphans[detail->orphan_count++] = oid;
+}
+
+// Points a link of the oid at parent to child, marking the change.
+static void topo_link(TimelineTopologyDetail* detail, uint32_t parent, 
+        IntervalOidId* link, IntervalOidId child) {
+    if (link->id == child.id)
+        return;
 
-#endif // IMPL_OPENTIME_CURVE
+    topo_mark_orphan(detail, *link);
+    *link = child;
+    topo_mark_dirty(detail, OT_OID_INDEX(parent), TOPO_DIRTY_LINKS);
+}
 
+static inline void topo_widen(OT_TimeInterval* range, OT_TimeInterval b) {
+    if (b.start.t < range->start.t)
+        range->start = b.start;
+    if (b.end.t > range->end.t)
+        range->end = b.end;
+}
 
-//------- opentimeline.h starts here
-#include <stddef.h>
-#include <stdint.h>
-#include <string.h>
+// Flags of an oid in the active clip index.
+#define TOPO_ACTIVE_INDEXED 1
+#define TOPO_ACTIVE_STALE 2
+#define TOPO_ACTIVE_DELTA 4
 
-typedef struct { uint32_t id; } IntervalOidId;
-const IntervalOidId IntervalOidId_default = { 0 };
-struct TimelineTopologyInterface;
-typedef struct TimelineTopologyInterface TimelineTopologyInterface;
+// A leaf is a placed oid with no children, which is what plays.
+static inline bool topo_is_leaf(TimelineTopologyDetail* detail, uint32_t index) {
+    if (index == 0 || !detail->flat.reached[index])
+        return false;
 
-typedef struct {
-    IntervalOidId self;
-    IntervalOidId seq;
-    IntervalOidId sync;
-    OT_TimeAffineTransform basis;
-    bool reset_transform;
-    OT_TimeInterval bounds;
-    //OT_TImeCurve mapping;
-} IntervalOid;
-const IntervalOid IntervalOid_default = {{0}, {0}, {0},
-    { {0}, 1.f }, false,
-    {{0}, {INFINITY}}};
+    IntervalOid* oid = topo_oid(detail, index);
+    IntervalOidId children = detail->kinds[index] ? oid->sync : oid->seq;
+    return OT_OID_INDEX(children.id) == 0 || !topo_live(detail, children.id);
+}
 
-struct TimelineTopologyDetail;
-typedef struct TimelineTopologyDetail TimelineTopologyDetail;
+// Indexes the global bounds of every leaf afresh and empties the delta.
+static bool topo_rebuild_active(TimelineTopologyDetail* detail) {
+    TimelineFlatCache* flat = &detail->flat;
+    int count = flat->count;
+    OT_TimeInterval* intervals = 
+        (OT_TimeInterval*) detail->alloc->malloc(sizeof(OT_TimeInterval) * count);
+    if (!intervals) {
+        detail->active_built = false;
+        return false;
+    }
 
-struct TimelineTopologyInterface {
-    IntervalOid timeline_root;
+    // non leaves get empty intervals, which are not indexed
+    for (int i = 0; i < count; ++i) {
+        bool leaf = topo_is_leaf(detail, (uint32_t) i);
+        intervals[i] = leaf ? flat->bounds[i] : (OT_TimeInterval) {{ 0 }, { 0 }};
+        detail->active_flags[i] = leaf ? TOPO_ACTIVE_INDEXED : 0;
+    }
+    ot_interval_index_deinit(&detail->active);
+    detail->active_built = ot_interval_index_build(&detail->active, &detail->active_alloc, 
+            intervals, (size_t) count);
+    detail->alloc->free(intervals);
+    detail->active_delta_count = 0;
+    return detail->active_built;
+}
 
-    void (*deinit)(TimelineTopologyInterface* self);
+// Brings the index's view of the oid at index up to date, given whether
+// its bounds changed.
+static void topo_touch_active(TimelineTopologyDetail* detail, uint32_t index, bool changed) {
+    if (!detail->active_built)
+        return;
 
-    IntervalOidId (*new_oid)(TimelineTopologyInterface* self);
-    
-    void (*add_sync)(TimelineTopologyInterface* self, IntervalOidId parent, IntervalOidId);
-    void (*add_seq)(TimelineTopologyInterface* self, IntervalOidId parent, IntervalOidId);
-    void (*add_syncs)(TimelineTopologyInterface* self, IntervalOidId parent, 
-            IntervalOidId* first, IntervalOidId* last);
-    void (*add_seqs)(TimelineTopologyInterface* self, IntervalOidId parent, 
-            IntervalOidId* first, IntervalOidId* last);
-    
-    TimelineTopologyDetail* detail;
-};
+    uint8_t* flags = &detail->active_flags[index];
+    bool leaf = topo_is_leaf(detail, index);
+    if ((*flags & TOPO_ACTIVE_INDEXED) && (changed || !leaf))
+        *flags |= TOPO_ACTIVE_STALE;
+    if (!leaf || (*flags & TOPO_ACTIVE_DELTA) || 
+            (*flags & (TOPO_ACTIVE_INDEXED | TOPO_ACTIVE_STALE)) == TOPO_ACTIVE_INDEXED)
+        return;
 
-typedef struct {
-    void* (*malloc)(size_t);
-    void (*free)(void*);
-} TimelineAllocator;
+    // on failure the next reflatten flattens afresh, which rebuilds the index
+    if (detail->active_delta_count == detail->active_delta_capacity &&
+            !topo_grow_list(detail, (void**) &detail->active_delta, 
+                &detail->active_delta_capacity, sizeof(uint32_t)))
+        return;
 
-TimelineTopologyInterface*
-timeline_topology_create(
-        int initial_capacity,
-        TimelineAllocator*);
+    detail->active_delta[detail->active_delta_count++] = index;
+    *flags |= TOPO_ACTIVE_DELTA;
+}
 
-#define OPENTIMELINE_IMPL
-#ifdef OPENTIMELINE_IMPL
+// Carries a pass's changes into the index. Indexed entries of changed
+// oids go stale, and changed leaves join a delta that queries scan, until
+// the delta outgrows about the square root of the oid count and the
+// index is rebuilt. An oid gains or loses its last child only when that
+// child is placed or unplaced, so the parents of changed oids are
+// checked for having become or ceased to be leaves; those of unplaced
+// oids are checked as they are unplaced, before the oid can be placed
+// under another parent.
+static void topo_sync_active(TimelineTopologyDetail* detail) {
+    if (!detail->active_built)
+        return;
 
-#ifdef TESTING
-#include <stdlib.h>
-#endif
+    TimelineFlatCache* flat = &detail->flat;
+    if (flat->rebuilt) {
+        topo_rebuild_active(detail);
+        return;
+    }
 
-struct TimelineTopologyDetail {
-    TimelineAllocator* alloc;
-    IntervalOid* timeline_data;
-    int next_available;
-    int last_available;
-};
+    for (int i = 0; i < flat->changed_count; ++i) {
+        uint32_t index = flat->changed[i];
+        topo_touch_active(detail, index, true);
+        topo_touch_active(detail, detail->parents[index], false);
+    }
+
+    int limit = 64;
+    while (limit * limit < flat->count)
+        limit *= 2;
+    if (detail->active_delta_count > limit)
+        topo_rebuild_active(detail);
+}
 
 static void topo_deinit(TimelineTopologyInterface* self) {
     if (!self || !self->detail)
@@ -879,33 +4941,123 @@ static void topo_deinit(TimelineTopologyInterface* self) {
         return;
 
     void (*freeFn)(void*) = detail->alloc->free;
-    freeFn(detail->timeline_data);
+    for (int i = 0; i < detail->page_count; ++i)
+        freeFn(detail->pages[i].oids);
+    freeFn(detail->pages);
+    freeFn(detail->free_pages);
+    freeFn(detail->flat_block);
+    freeFn(detail->dirty_list);
+    freeFn(detail->orphans);
+    freeFn(detail->active_delta);
+    ot_interval_index_deinit(&detail->active);
     freeFn(self->detail);
     freeFn(self);
 }
 
+// Reuses a deleted slot from the lowest page that has one, so that the
+// live oids stay packed toward the start, and otherwise takes the next
+// unused slot.
 static IntervalOidId topo_new_oid(TimelineTopologyInterface* self) {
     if (!self)
         return IntervalOidId_default;
 
     TimelineTopologyDetail* detail = (TimelineTopologyDetail*) self->detail;
-    if (!detail || (detail->next_available == detail->last_available))
+    if (!detail)
+        return IntervalOidId_default;
+
+    int p = topo_lowest_free_page(detail);
+    if (p >= 0) {
+        TimelineTopologyPage* page = &detail->pages[p];
+        IntervalOid* oid = &page->oids[page->free_head];
+        uint32_t index = ((uint32_t) p << OT_TOPO_PAGE_SHIFT) + page->free_head;
+        uint32_t generation = oid->sync.id;
+        page->free_head = oid->seq.id;
+        if (page->free_head == OT_TOPO_PAGE_SIZE)
+            detail->free_pages[p / 64] &= ~((uint64_t) 1 << (p % 64));
+
+        *oid = IntervalOid_default;
+        oid->self.id = (generation << OT_OID_INDEX_BITS) | index;
+        return oid->self;
+    }
+
+    // the last index is left unused so that no id equals OT_OID_FREE
+    if ((uint32_t) detail->next_available >= OT_OID_INDEX_MASK)
+        return IntervalOidId_default;
+    if ((detail->next_available >> OT_TOPO_PAGE_SHIFT) == detail->page_count &&
+            !topo_add_page(detail))
         return IntervalOidId_default;
 
     IntervalOidId result = { detail->next_available++ };
     return result;
 }
 
+// Frees the slot for reuse under the next generation, so that the id and
+// any copies of it go stale. A slot on its last generation is retired
+// rather than freed. Links to and from the oid are not followed; unlink
+// it first. The root cannot be deleted.
+static bool topo_delete_oid(TimelineTopologyInterface* self, IntervalOidId oid) {
+    if (!self)
+        return false;
+
+    TimelineTopologyDetail* detail = (TimelineTopologyDetail*) self->detail;
+    if (!detail || OT_OID_INDEX(oid.id) == 0 || !topo_live(detail, oid.id))
+        return false;
+
+    uint32_t index = OT_OID_INDEX(oid.id);
+    int p = (int) (index >> OT_TOPO_PAGE_SHIFT);
+    TimelineTopologyPage* page = &detail->pages[p];
+    IntervalOid* slot = topo_oid(detail, oid.id);
+
+    // what hung off the oid leaves the timeline with it
+    if (detail->flattened && (int) index < detail->flat.count && detail->flat.reached[index]) {
+        topo_mark_orphan(detail, slot->seq);
+        topo_mark_orphan(detail, slot->sync);
+        topo_widen(&detail->vacated, detail->flat.bounds[index]);
+        detail->flat.reached[index] = 0;
+        topo_mark_dirty(detail, index, TOPO_DIRTY_DELETED);
+    }
+    slot->self.id = OT_OID_FREE;
+    if (detail->flattened && (int) index < detail->flat.count)
+        topo_touch_active(detail, detail->parents[index], false);
+    uint32_t generation = OT_OID_GENERATION(oid.id) + 1;
+    if (generation > OT_OID_GENERATION_MASK) {
+        // reusing the slot would hand out its first id again
+        slot->seq = IntervalOidId_default;
+        slot->sync = IntervalOidId_default;
+        return true;
+    }
+    slot->sync.id = generation;
+    slot->seq.id = page->free_head;
+    page->free_head = index & OT_TOPO_PAGE_MASK;
+    detail->free_pages[p / 64] |= (uint64_t) 1 << (p % 64);
+    if (p / 64 < detail->free_word)
+        detail->free_word = p / 64;
+    return true;
+}
+
+// Returns NULL for an id that was not handed out or has been deleted.
+static IntervalOid* topo_get_oid(TimelineTopologyInterface* self, IntervalOidId oid) {
+    if (!self)
+        return NULL;
+
+    TimelineTopologyDetail* detail = (TimelineTopologyDetail*) self->detail;
+    if (!detail || !topo_live(detail, oid.id))
+        return NULL;
+
+    return topo_oid(detail, oid.id);
+}
+
 static void topo_add_sync(TimelineTopologyInterface* self, 
         IntervalOidId parent, IntervalOidId child) {
     if (!self)
         return;
 
     TimelineTopologyDetail* detail = (TimelineTopologyDetail*) self->detail;
-    if (!detail)
+    if (!detail || !topo_live(detail, parent.id))
         return;
 
-    detail->timeline_data[parent.id].sync = child;
+    IntervalOid* oid = topo_oid(detail, parent.id);
+    topo_link(detail, parent.id, &oid->sync, child);
 }
 
 static void topo_add_seq(TimelineTopologyInterface* self, 
@@ -914,10 +5066,11 @@ static void topo_add_seq(TimelineTopologyInterface* self,
         return;
 
     TimelineTopologyDetail* detail = (TimelineTopologyDetail*) self->detail;
-    if (!detail)
+    if (!detail || !topo_live(detail, parent.id))
         return;
 
-    detail->timeline_data[parent.id].seq = child;
+    IntervalOid* oid = topo_oid(detail, parent.id);
+    topo_link(detail, parent.id, &oid->seq, child);
 }
 
 static void topo_add_seqs(TimelineTopologyInterface* self, 
@@ -926,12 +5079,12 @@ static void topo_add_seqs(TimelineTopologyInterface* self,
         return;
 
     TimelineTopologyDetail* detail = (TimelineTopologyDetail*) self->detail;
-    if (!detail)
+    if (!detail || !topo_live(detail, parent.id))
         return;
 
-    int root = parent.id;
-    for (IntervalOidId* i = first; i != last; ++i) {
-        detail->timeline_data[root].seq = *i;
+    uint32_t root = parent.id;
+    for (IntervalOidId* i = first; i != last && topo_live(detail, i->id); ++i) {
+        topo_link(detail, root, &topo_oid(detail, root)->seq, *i);
         root = i->id;
     }
 }
@@ -942,16 +5095,426 @@ static void topo_add_syncs(TimelineTopologyInterface* self,
         return;
 
     TimelineTopologyDetail* detail = (TimelineTopologyDetail*) self->detail;
-    if (!detail)
+    if (!detail || !topo_live(detail, parent.id))
         return;
 
-    int root = parent.id;
-    for (IntervalOidId* i = first; i != last; ++i) {
-        detail->timeline_data[root].sync = *i;
+    uint32_t root = parent.id;
+    for (IntervalOidId* i = first; i != last && topo_live(detail, i->id); ++i) {
+        topo_link(detail, root, &topo_oid(detail, root)->sync, *i);
         root = i->id;
     }
 }
 
+// Adds the oid at index to the pass's list of changed oids, once.
+static inline void topo_list_change(TimelineTopologyDetail* detail, uint32_t index) {
+    if (detail->listed[index] == detail->pass)
+        return;
+
+    detail->listed[index] = detail->pass;
+    detail->flat.changed[detail->flat.changed_count++] = index;
+}
+
+// Places the chain of siblings starting at frame->first. Each is placed
+// by its basis, composed after its parent's global transform; in a
+// sequence each is also shifted to start where its predecessor's bounds
+// ended. A sibling's children are pushed as frames of their own. When
+// track is set, the oids that move are listed and their old and new
+// bounds widen range, and the children of an oid that did not move and
+// whose links did not change are left as they are.
+static void topo_flatten_chain(TimelineTopologyDetail* detail, TopoFlattenFrame* frame, 
+        int* depth, bool track, OT_TimeInterval* range) {
+    TimelineFlatCache* flat = &detail->flat;
+    bool seq = frame->seq;
+    float slot = frame->slot;
+    OT_TimeAffineTransform parent = flat->transforms[frame->parent];
+    uint32_t level = detail->depths[frame->parent] + 1;
+    IntervalOidId id = frame->first;
+    bool first = true;
+    while (OT_OID_INDEX(id.id) != 0 && topo_live(detail, id.id)) {
+        uint32_t index = OT_OID_INDEX(id.id);
+        if (detail->stamps[index] == detail->walk)
+            break;
+
+        // once a sibling is where it was, so is the rest of the chain
+        if (frame->partial && !first && flat->reached[index] && !detail->dirty[index] &&
+                detail->parents[index] == frame->parent && detail->kinds[index] == seq &&
+                detail->slots[index] == slot)
+            break;
+
+        IntervalOid* oid = topo_oid(detail, id.id);
+        OT_TimeInterval extent = ot_inline_transform_interval(oid->basis, oid->bounds);
+        float lo = fminf(extent.start.t, extent.end.t);
+        float hi = fmaxf(extent.start.t, extent.end.t);
+        OT_TimeAffineTransform local = oid->basis;
+        if (seq && isfinite(lo))
+            local.t.t += slot - lo;
+
+        OT_TimeAffineTransform global = oid->reset_transform 
+            ? oid->basis : ot_inline_compose_transform(parent, local);
+        OT_TimeInterval bounds = ot_inline_transform_interval(global, oid->bounds);
+        if (bounds.end.t < bounds.start.t)
+            bounds = (OT_TimeInterval) { bounds.end, bounds.start };
+
+        bool moved = !flat->reached[index] || 
+            flat->transforms[index].t.t != global.t.t || flat->transforms[index].s != global.s;
+        bool relinked = detail->dirty[index] & TOPO_DIRTY_LINKS;
+        if (track && (moved || flat->bounds[index].start.t != bounds.start.t || 
+                    flat->bounds[index].end.t != bounds.end.t)) {
+            if (flat->reached[index])
+                topo_widen(range, flat->bounds[index]);
+            topo_widen(range, bounds);
+            topo_list_change(detail, index);
+        }
+
+        flat->transforms[index] = global;
+        flat->bounds[index] = bounds;
+        flat->reached[index] = 1;
+        detail->parents[index] = frame->parent;
+        detail->slots[index] = slot;
+        detail->kinds[index] = seq;
+        detail->depths[index] = level;
+        detail->stamps[index] = detail->walk;
+        detail->dirty[index] = 0;
+
+        IntervalOidId children = seq ? oid->sync : oid->seq;
+        if (OT_OID_INDEX(children.id) != 0 && (!track || moved || relinked))
+            detail->frames[(*depth)++] = 
+                (TopoFlattenFrame) { children, index, 0.f, !seq, false };
+
+        slot += hi - lo;
+        id = seq ? oid->seq : oid->sync;
+        first = false;
+    }
+}
+
+// Places the root by its basis and pushes its children if it moved or
+// its links changed.
+static void topo_flatten_root(TimelineTopologyDetail* detail, int* depth, 
+        bool track, OT_TimeInterval* range) {
+    TimelineFlatCache* flat = &detail->flat;
+    IntervalOid* root = topo_oid(detail, 0);
+    bool moved = !flat->reached[0] || 
+        flat->transforms[0].t.t != root->basis.t.t || flat->transforms[0].s != root->basis.s;
+    bool relinked = detail->dirty[0] & TOPO_DIRTY_LINKS;
+    OT_TimeInterval bounds = ot_inline_transform_interval(root->basis, root->bounds);
+    if (track && (moved || flat->bounds[0].start.t != bounds.start.t || 
+                flat->bounds[0].end.t != bounds.end.t)) {
+        if (flat->reached[0])
+            topo_widen(range, flat->bounds[0]);
+        topo_widen(range, bounds);
+        topo_list_change(detail, 0);
+    }
+    flat->transforms[0] = root->basis;
+    flat->bounds[0] = bounds;
+    flat->reached[0] = 1;
+    detail->depths[0] = 0;
+    detail->stamps[0] = detail->walk;
+    detail->dirty[0] = 0;
+    if (track && !moved && !relinked)
+        return;
+
+    // every oid pushes at most one frame, so the stack cannot overflow
+    if (OT_OID_INDEX(root->sync.id) != 0)
+        detail->frames[(*depth)++] = (TopoFlattenFrame) { root->sync, 0, 0.f, false, false };
+    if (OT_OID_INDEX(root->seq.id) != 0)
+        detail->frames[(*depth)++] = (TopoFlattenFrame) { root->seq, 0, 0.f, true, false };
+}
+
+static void topo_flatten_frames(TimelineTopologyDetail* detail, int depth, 
+        bool track, OT_TimeInterval* range) {
+    while (depth > 0) {
+        TopoFlattenFrame frame = detail->frames[--depth];
+        topo_flatten_chain(detail, &frame, &depth, track, range);
+    }
+}
+
+// Computes the global transform and bounds of every oid reachable from
+// the root into the flat cache, in one pass over the topology. The root's
+// seq link starts a sequence and its sync link a stack. Below that, a
+// link of the kind an oid was reached by leads to its next sibling and
+// the other kind to its first child, as add_seqs and add_syncs build
+// them. An oid with reset_transform is placed by its basis alone.
+// Returns NULL if the cache cannot be allocated.
+static const TimelineFlatCache* topo_flatten(TimelineTopologyInterface* self) {
+    if (!self)
+        return NULL;
+
+    TimelineTopologyDetail* detail = (TimelineTopologyDetail*) self->detail;
+    if (!detail || !topo_reserve_flat(detail))
+        return NULL;
+
+    TimelineFlatCache* flat = &detail->flat;
+    flat->count = detail->next_available;
+    flat->changed_count = 0;
+    flat->rebuilt = true;
+    memset(flat->reached, 0, (size_t) flat->count);
+    memset(detail->dirty, 0, (size_t) flat->count);
+    detail->dirty_count = 0;
+    detail->orphan_count = 0;
+    detail->vacated = (OT_TimeInterval) {{ INFINITY }, { -INFINITY }};
+    detail->flattened = true;
+    ++detail->pass;
+    ++detail->walk;
+
+    int depth = 0;
+    topo_flatten_root(detail, &depth, false, NULL);
+    topo_flatten_frames(detail, depth, false, NULL);
+    topo_sync_active(detail);
+    return flat;
+}
+
+// Takes the oids after and below an orphaned link off the timeline,
+// except those placed again in this pass.
+static void topo_unreach(TimelineTopologyDetail* detail, IntervalOidId orphan, 
+        OT_TimeInterval* range) {
+    TimelineFlatCache* flat = &detail->flat;
+    int depth = 0;
+    detail->frames[depth++].first = orphan;
+    while (depth > 0) {
+        IntervalOidId id = detail->frames[--depth].first;
+        uint32_t index = OT_OID_INDEX(id.id);
+        if (index == 0 || !topo_live(detail, id.id) || !flat->reached[index])
+            continue;
+
+        topo_widen(range, flat->bounds[index]);
+        topo_list_change(detail, index);
+        flat->reached[index] = 0;
+        topo_touch_active(detail, detail->parents[index], false);
+        IntervalOid* oid = topo_oid(detail, id.id);
+        detail->frames[depth++].first = oid->seq;
+        detail->frames[depth++].first = oid->sync;
+    }
+}
+
+static int topo_dirty_cmp(const void* a, const void* b) {
+    const TopoDirtyEntry* x = (const TopoDirtyEntry*) a;
+    const TopoDirtyEntry* y = (const TopoDirtyEntry*) b;
+    if (x->depth != y->depth)
+        return x->depth < y->depth ? -1 : 1;
+    if (x->slot != y->slot)
+        return x->slot < y->slot ? -1 : 1;
+    return x->index < y->index ? -1 : x->index > y->index;
+}
+
+// Brings the flat cache up to date with the edits made since the last
+// flatten or reflatten, placing again only the oids that were edited or
+// relinked, their children if they moved, and the siblings after them
+// until one is found in place. Edits must go through the set_* and add_*
+// calls; after editing an oid directly, call flatten instead.
+//
+// changed_out receives the span of global time whose contents changed,
+// and the cache lists the indices of the oids that moved, were resized or
+// left the timeline. With nothing changed the list is empty and the span
+// is [0, 0). The first call, or one after an allocation failure, flattens
+// everything and reports the whole timeline.
+static const TimelineFlatCache* topo_reflatten(TimelineTopologyInterface* self, 
+        OT_TimeInterval* changed_out) {
+    if (!self)
+        return NULL;
+
+    TimelineTopologyDetail* detail = (TimelineTopologyDetail*) self->detail;
+    if (!detail)
+        return NULL;
+
+    if (!detail->flattened) {
+        if (changed_out)
+            *changed_out = OT_TimeInterval_continuum;
+        return topo_flatten(self);
+    }
+    if (!topo_reserve_flat(detail))
+        return NULL;
+
+    TimelineFlatCache* flat = &detail->flat;
+    flat->count = detail->next_available;
+    flat->changed_count = 0;
+    flat->rebuilt = false;
+    ++detail->pass;
+    OT_TimeInterval range = detail->vacated;
+    detail->vacated = (OT_TimeInterval) {{ INFINITY }, { -INFINITY }};
+
+    // detach first, so that oids linked elsewhere are then placed anew
+    for (int i = 0; i < detail->orphan_count; ++i)
+        topo_unreach(detail, detail->orphans[i], &range);
+
+    // parents before children and earlier siblings before later ones, so
+    // that a walk seldom covers oids that a later walk places again
+    for (int i = 0; i < detail->dirty_count; ++i) {
+        TopoDirtyEntry* e = &detail->dirty_list[i];
+        e->depth = flat->reached[e->index] ? detail->depths[e->index] : UINT32_MAX;
+        e->slot = detail->slots[e->index];
+    }
+    if (detail->dirty_count > 1)
+        qsort(detail->dirty_list, (size_t) detail->dirty_count, sizeof(TopoDirtyEntry), 
+                topo_dirty_cmp);
+
+    for (int i = 0; i < detail->dirty_count; ++i) {
+        uint32_t index = detail->dirty_list[i].index;
+        uint8_t why = detail->dirty[index];
+        if (why & TOPO_DIRTY_DELETED)
+            topo_list_change(detail, index);
+        if (!why)
+            continue;
+
+        // an oid off the timeline is placed when something links to it
+        ++detail->walk;
+        int depth = 0;
+        if (index == 0) {
+            topo_flatten_root(detail, &depth, true, &range);
+        }
+        else if (flat->reached[index]) {
+            detail->frames[depth++] = (TopoFlattenFrame) { 
+                topo_oid(detail, index)->self, detail->parents[index], 
+                detail->slots[index], detail->kinds[index], true };
+        }
+        topo_flatten_frames(detail, depth, true, &range);
+        detail->dirty[index] = 0;
+    }
+    detail->dirty_count = 0;
+    detail->orphan_count = 0;
+    topo_sync_active(detail);
+
+    if (changed_out)
+        *changed_out = flat->changed_count ? range : (OT_TimeInterval) {{ 0 }, { 0 }};
+    return flat;
+}
+
+// Setters that keep the flat cache's record of edits.
+static void topo_set_basis(TimelineTopologyInterface* self, IntervalOidId oid, 
+        OT_TimeAffineTransform basis) {
+    if (!self)
+        return;
+
+    TimelineTopologyDetail* detail = (TimelineTopologyDetail*) self->detail;
+    if (!detail || !topo_live(detail, oid.id))
+        return;
+
+    topo_oid(detail, oid.id)->basis = basis;
+    topo_mark_dirty(detail, OT_OID_INDEX(oid.id), TOPO_DIRTY_SELF);
+}
+
+static void topo_set_bounds(TimelineTopologyInterface* self, IntervalOidId oid, 
+        OT_TimeInterval bounds) {
+    if (!self)
+        return;
+
+    TimelineTopologyDetail* detail = (TimelineTopologyDetail*) self->detail;
+    if (!detail || !topo_live(detail, oid.id))
+        return;
+
+    topo_oid(detail, oid.id)->bounds = bounds;
+    topo_mark_dirty(detail, OT_OID_INDEX(oid.id), TOPO_DIRTY_SELF);
+}
+
+static void topo_set_reset_transform(TimelineTopologyInterface* self, IntervalOidId oid, 
+        bool reset_transform) {
+    if (!self)
+        return;
+
+    TimelineTopologyDetail* detail = (TimelineTopologyDetail*) self->detail;
+    if (!detail || !topo_live(detail, oid.id))
+        return;
+
+    topo_oid(detail, oid.id)->reset_transform = reset_transform;
+    topo_mark_dirty(detail, OT_OID_INDEX(oid.id), TOPO_DIRTY_SELF);
+}
+
+// Indexes the leaves of the flat cache by their global bounds, flattening
+// first if needed. From then on flatten and reflatten keep the index up
+// to date, and active_at and active_in answer from it.
+static bool topo_build_active_index(TimelineTopologyInterface* self) {
+    if (!self)
+        return false;
+
+    TimelineTopologyDetail* detail = (TimelineTopologyDetail*) self->detail;
+    if (!detail)
+        return false;
+
+    if (!detail->flattened && !topo_flatten(self))
+        return false;
+    return topo_rebuild_active(detail);
+}
+
+typedef struct {
+    TimelineTopologyDetail* detail;
+    TimelineActiveClip* out;
+    size_t capacity;
+    size_t count;
+    OT_TimeInterval range;
+} TopoActiveCollector;
+
+// Reports the leaf at index, at the local time of the start of its
+// overlap with the range.
+static void topo_active_report(TopoActiveCollector* c, uint32_t index) {
+    TimelineTopologyDetail* detail = c->detail;
+    if (c->count < c->capacity) {
+        OT_seconds t = c->range.start;
+        if (detail->flat.bounds[index].start.t > t.t)
+            t = detail->flat.bounds[index].start;
+        OT_TimeAffineTransform to_local = 
+            ot_inline_invert_transform(detail->flat.transforms[index]);
+        c->out[c->count].oid = topo_oid(detail, index)->self;
+        c->out[c->count].local = ot_inline_transform_seconds(to_local, t);
+    }
+    ++c->count;
+}
+
+static void topo_active_collect(void* ctx, uint32_t index) {
+    TopoActiveCollector* c = (TopoActiveCollector*) ctx;
+
+    // deleting an oid unplaces it at once, ahead of the next reflatten
+    if (!(c->detail->active_flags[index] & TOPO_ACTIVE_STALE) && c->detail->flat.reached[index])
+        topo_active_report(c, index);
+}
+
+// Writes the leaves containing global time t, with t in each one's local
+// time, to out, as of the last flatten or reflatten. Returns the number
+// of leaves found, which may exceed capacity. Queries are O(log n + k),
+// plus a scan of the leaves changed since the index was last rebuilt.
+static size_t topo_active_at(TimelineTopologyInterface* self, OT_seconds t, 
+        TimelineActiveClip* out, size_t capacity) {
+    if (!self || (!out && capacity > 0))
+        return 0;
+
+    TimelineTopologyDetail* detail = (TimelineTopologyDetail*) self->detail;
+    if (!detail || !detail->active_built)
+        return 0;
+
+    TopoActiveCollector c = { detail, out, capacity, 0, { t, t } };
+    ot_interval_index_visit_stab(&detail->active, t.t, false, topo_active_collect, &c);
+    for (int i = 0; i < detail->active_delta_count; ++i) {
+        uint32_t index = detail->active_delta[i];
+        OT_TimeInterval b = detail->flat.bounds[index];
+        if (topo_is_leaf(detail, index) && b.start.t <= t.t && t.t < b.end.t) {
+            topo_active_report(&c, index);
+        }
+    }
+    return c.count;
+}
+
+// As active_at, for the leaves overlapping [range.start, range.end), each
+// with the local time at which its overlap begins.
+static size_t topo_active_in(TimelineTopologyInterface* self, OT_TimeInterval range, 
+        TimelineActiveClip* out, size_t capacity) {
+    if (!self || (!out && capacity > 0))
+        return 0;
+
+    TimelineTopologyDetail* detail = (TimelineTopologyDetail*) self->detail;
+    if (!detail || !detail->active_built || !(range.start.t < range.end.t))
+        return 0;
+
+    TopoActiveCollector c = { detail, out, capacity, 0, range };
+    ot_interval_index_visit_overlapping(&detail->active, range, topo_active_collect, &c);
+    for (int i = 0; i < detail->active_delta_count; ++i) {
+        uint32_t index = detail->active_delta[i];
+        OT_TimeInterval b = detail->flat.bounds[index];
+        if (topo_is_leaf(detail, index) && b.start.t < b.end.t && 
+                b.start.t < range.end.t && range.start.t < b.end.t) {
+            topo_active_report(&c, index);
+        }
+    }
+    return c.count;
+}
+
 TimelineTopologyInterface* 
 timeline_topology_create(
         int initial_capacity,
@@ -968,24 +5531,41 @@ timeline_topology_create(
     topo->timeline_root = IntervalOid_default;
     TimelineTopologyDetail* detail = 
         (TimelineTopologyDetail*) alloc->malloc(sizeof(TimelineTopologyDetail));
-    detail->alloc = (void*) alloc;
-    detail->timeline_data = 
-        (IntervalOid*) alloc->malloc(sizeof(IntervalOid) * (1 + initial_capacity));
-    memset(detail->timeline_data, 0, sizeof(IntervalOid) * (1 + initial_capacity));
-    for (int i = 0; i < initial_capacity; ++i) {
-        detail->timeline_data[i].self.id = i;
-        detail->timeline_data[i].bounds = OT_TimeInterval_default;
+    if (!detail) {
+        alloc->free(topo);
+        return NULL;
     }
+    memset(detail, 0, sizeof(TimelineTopologyDetail));
+    detail->alloc = (void*) alloc;
+    detail->active_alloc = (OpenTimeAllocator) { alloc->malloc, alloc->free };
+    detail->active.root = -1;
 
+    // slot 0 holds the root's links
     topo->detail = (void*) detail;
     detail->next_available = 1;
-    detail->last_available = initial_capacity;
     topo->deinit = topo_deinit;
+    do {
+        if (!topo_add_page(detail)) {
+            topo_deinit(topo);
+            return NULL;
+        }
+    } while (detail->page_count * OT_TOPO_PAGE_SIZE < initial_capacity);
+
     topo->new_oid = topo_new_oid;
+    topo->delete_oid = topo_delete_oid;
+    topo->get_oid = topo_get_oid;
     topo->add_sync = topo_add_sync;
     topo->add_seq = topo_add_seq;
     topo->add_seqs = topo_add_seqs;
     topo->add_syncs = topo_add_syncs;
+    topo->set_basis = topo_set_basis;
+    topo->set_bounds = topo_set_bounds;
+    topo->set_reset_transform = topo_set_reset_transform;
+    topo->flatten = topo_flatten;
+    topo->reflatten = topo_reflatten;
+    topo->build_active_index = topo_build_active_index;
+    topo->active_at = topo_active_at;
+    topo->active_in = topo_active_in;
     return topo;
 }
 
@@ -1011,14 +5591,204 @@ void test_creation() {
     }
 }
 
-#endif // TESTING
+void test_topology_growth() {
+    TimelineAllocator alloc = { .malloc = malloc, .free = free };
+    TimelineTopologyInterface* topo = timeline_topology_create(1, &alloc);
+
+    IntervalOidId first = topo->new_oid(topo);
+    IntervalOid* oid = topo->get_oid(topo, first);
+    oid->bounds.end.t = 10.f;
+    {
+        // several pages on, the first oid has not moved
+        IntervalOidId last = first;
+        for (int i = 0; i < 3 * OT_TOPO_PAGE_SIZE; ++i)
+            last = topo->new_oid(topo);
+        bool success = OT_CHECK(last.id == first.id + 3 * OT_TOPO_PAGE_SIZE);
+        success = OT_CHECK(topo->get_oid(topo, first) == oid && oid->bounds.end.t == 10.f);
+        success = OT_CHECK(topo->get_oid(topo, last)->self.id == last.id);
+        success = OT_CHECK(topo->get_oid(topo, (IntervalOidId) { last.id + 1 }) == NULL);
+    }
+    topo->deinit(topo);
+}
+
+void test_oid_recycling() {
+    TimelineAllocator alloc = { .malloc = malloc, .free = free };
+    TimelineTopologyInterface* topo = timeline_topology_create(1, &alloc);
+
+    IntervalOidId a = topo->new_oid(topo);
+    IntervalOidId b = topo->new_oid(topo);
+    {
+        bool success = OT_CHECK(topo->delete_oid(topo, b));
+        success = OT_CHECK(topo->get_oid(topo, b) == NULL && topo->get_oid(topo, a) != NULL);
+        success = OT_CHECK(!topo->delete_oid(topo, b));
+        success = OT_CHECK(!topo->delete_oid(topo, topo->timeline_root.self));
+
+        // the slot comes back under a new generation
+        IntervalOidId c = topo->new_oid(topo);
+        success = OT_CHECK(OT_OID_INDEX(c.id) == OT_OID_INDEX(b.id) && c.id != b.id);
+        success = OT_CHECK(topo->get_oid(topo, c)->self.id == c.id && topo->get_oid(topo, b) == NULL);
+    }
+    {
+        // the lowest page with a free slot is reused first
+        IntervalOidId ids[2 * OT_TOPO_PAGE_SIZE];
+        for (int i = 0; i < 2 * OT_TOPO_PAGE_SIZE; ++i)
+            ids[i] = topo->new_oid(topo);
+        topo->delete_oid(topo, ids[2 * OT_TOPO_PAGE_SIZE - 1]);
+        topo->delete_oid(topo, a);
+        IntervalOidId d = topo->new_oid(topo);
+        bool success = OT_CHECK(OT_OID_INDEX(d.id) == OT_OID_INDEX(a.id));
+        IntervalOidId e = topo->new_oid(topo);
+        success = OT_CHECK(OT_OID_INDEX(e.id) == OT_OID_INDEX(ids[2 * OT_TOPO_PAGE_SIZE - 1].id));
+    }
+    {
+        // a slot is retired before its generation wraps, so a stale id
+        // never names a new oid
+        IntervalOidId track = topo->new_oid(topo);
+        IntervalOidId first = topo->new_oid(topo);
+        topo->add_seq(topo, track, first);
+        IntervalOidId clip = first;
+        bool success = true;
+        for (uint32_t i = 0; i < 2 * (OT_OID_GENERATION_MASK + 1); ++i) {
+            success = OT_CHECK(topo->delete_oid(topo, clip)) && success;
+            clip = topo->new_oid(topo);
+            success = OT_CHECK(clip.id != first.id) && success;
+        }
+        success = OT_CHECK(OT_OID_INDEX(clip.id) != OT_OID_INDEX(first.id));
+        success = OT_CHECK(topo->get_oid(topo, first) == NULL);
+        success = OT_CHECK(topo->get_oid(topo, topo->get_oid(topo, track)->seq) == NULL);
+    }
+    topo->deinit(topo);
+}
+
+void test_flatten() {
+    TimelineAllocator alloc = { .malloc = malloc, .free = free };
+    TimelineTopologyInterface* topo = timeline_topology_create(16, &alloc);
+
+    // a track at 100 holding three clips in sequence; the first clip
+    // holds a nested clip, and the last ignores where it is placed
+    IntervalOidId track = topo->new_oid(topo);
+    IntervalOidId clips[3] = { 
+        topo->new_oid(topo), topo->new_oid(topo), topo->new_oid(topo) };
+    IntervalOidId nested = topo->new_oid(topo);
+    IntervalOidId loose = topo->new_oid(topo);
+    topo->get_oid(topo, track)->basis = (OT_TimeAffineTransform) {{ 100 }, 1 };
+    topo->get_oid(topo, clips[0])->bounds = (OT_TimeInterval) {{ 0 }, { 10 }};
+    topo->get_oid(topo, clips[1])->bounds = (OT_TimeInterval) {{ 5 }, { 10 }};
+    topo->get_oid(topo, clips[1])->basis = (OT_TimeAffineTransform) {{ 0 }, 2 };
+    topo->get_oid(topo, clips[2])->bounds = (OT_TimeInterval) {{ 0 }, { 4 }};
+    topo->get_oid(topo, clips[2])->basis = (OT_TimeAffineTransform) {{ 7 }, 1 };
+    topo->get_oid(topo, clips[2])->reset_transform = true;
+    topo->get_oid(topo, nested)->bounds = (OT_TimeInterval) {{ 1 }, { 2 }};
+    topo->add_sync(topo, topo->timeline_root.self, track);
+    topo->add_seqs(topo, track, &clips[0], &clips[3]);
+    topo->add_sync(topo, clips[0], nested);
+
+    const TimelineFlatCache* flat = topo->flatten(topo);
+    {
+        bool success = OT_CHECK(flat->reached[OT_OID_INDEX(track.id)] && 
+            !flat->reached[OT_OID_INDEX(loose.id)]);
+        OT_TimeInterval* b = flat->bounds;
+        success = OT_CHECK(b[OT_OID_INDEX(track.id)].start.t == 100.f);
+        success = OT_CHECK(b[OT_OID_INDEX(clips[0].id)].start.t == 100.f &&
+            b[OT_OID_INDEX(clips[0].id)].end.t == 110.f);
+        success = OT_CHECK(b[OT_OID_INDEX(clips[1].id)].start.t == 110.f &&
+            b[OT_OID_INDEX(clips[1].id)].end.t == 120.f);
+        success = OT_CHECK(b[OT_OID_INDEX(clips[2].id)].start.t == 7.f &&
+            b[OT_OID_INDEX(clips[2].id)].end.t == 11.f);
+        success = OT_CHECK(b[OT_OID_INDEX(nested.id)].start.t == 101.f &&
+            b[OT_OID_INDEX(nested.id)].end.t == 102.f);
+
+        // local 5 of the scaled clip is where it starts
+        OT_TimeAffineTransform x = flat->transforms[OT_OID_INDEX(clips[1].id)];
+        success = OT_CHECK(x.s == 2.f && ot_inline_transform_seconds(x, (OT_seconds) { 5 }).t == 110.f);
+    }
+    topo->deinit(topo);
+}
+
+void test_reflatten() {
+    TimelineAllocator alloc = { .malloc = malloc, .free = free };
+    TimelineTopologyInterface* topo = timeline_topology_create(16, &alloc);
+
+    IntervalOidId track = topo->new_oid(topo);
+    IntervalOidId clips[3] = { 
+        topo->new_oid(topo), topo->new_oid(topo), topo->new_oid(topo) };
+    topo->set_basis(topo, track, (OT_TimeAffineTransform) {{ 100 }, 1 });
+    for (int i = 0; i < 3; ++i)
+        topo->set_bounds(topo, clips[i], (OT_TimeInterval) {{ 0 }, { 10 }});
+    topo->add_sync(topo, topo->timeline_root.self, track);
+    topo->add_seqs(topo, track, &clips[0], &clips[3]);
+
+    OT_TimeInterval changed;
+    const TimelineFlatCache* flat = topo->reflatten(topo, &changed);
+    {
+        bool success = OT_CHECK(flat->rebuilt && changed.start.t == -INFINITY);
+        flat = topo->reflatten(topo, &changed);
+        success = OT_CHECK(!flat->rebuilt && flat->changed_count == 0 && changed.end.t == 0.f);
+    }
+    {
+        // lengthening the first clip pushes the others later
+        topo->set_bounds(topo, clips[0], (OT_TimeInterval) {{ 0 }, { 15 }});
+        flat = topo->reflatten(topo, &changed);
+        bool success = OT_CHECK(flat->changed_count == 3);
+        success = OT_CHECK(changed.start.t == 100.f && changed.end.t == 135.f);
+        success = OT_CHECK(flat->bounds[OT_OID_INDEX(clips[2].id)].start.t == 125.f);
+    }
+    {
+        // cutting the sequence after the first clip takes the rest away
+        topo->add_seq(topo, clips[0], IntervalOidId_default);
+        flat = topo->reflatten(topo, &changed);
+        bool success = OT_CHECK(flat->changed_count == 2);
+        success = OT_CHECK(changed.start.t == 115.f && changed.end.t == 135.f);
+        success = OT_CHECK(!flat->reached[OT_OID_INDEX(clips[1].id)]);
+    }
+    topo->deinit(topo);
+}
 
+void test_active_clips() {
+    TimelineAllocator alloc = { .malloc = malloc, .free = free };
+    TimelineTopologyInterface* topo = timeline_topology_create(16, &alloc);
 
-int main(int argc, char** argv) {
-    test_creation();
-    return 0;
+    // a track at 100 holding three clips of 10 in sequence
+    IntervalOidId track = topo->new_oid(topo);
+    IntervalOidId clips[3] = { 
+        topo->new_oid(topo), topo->new_oid(topo), topo->new_oid(topo) };
+    topo->set_basis(topo, track, (OT_TimeAffineTransform) {{ 100 }, 1 });
+    for (int i = 0; i < 3; ++i)
+        topo->set_bounds(topo, clips[i], (OT_TimeInterval) {{ 0 }, { 10 }});
+    topo->add_sync(topo, topo->timeline_root.self, track);
+    topo->add_seqs(topo, track, &clips[0], &clips[3]);
+
+    TimelineActiveClip found[4];
+    bool success = OT_CHECK(topo->build_active_index(topo));
+    {
+        size_t count = topo->active_at(topo, (OT_seconds) { 115 }, found, 4);
+        success = OT_CHECK(count == 1 && found[0].oid.id == clips[1].id && found[0].local.t == 5.f);
+        success = OT_CHECK(topo->active_at(topo, (OT_seconds) { 130 }, found, 4) == 0);
+    }
+    {
+        // lengthening the first clip is seen once reflattened
+        topo->set_bounds(topo, clips[0], (OT_TimeInterval) {{ 0 }, { 20 }});
+        topo->reflatten(topo, NULL);
+        size_t count = topo->active_at(topo, (OT_seconds) { 115 }, found, 4);
+        success = OT_CHECK(count == 1 && found[0].oid.id == clips[0].id && found[0].local.t == 15.f);
+        count = topo->active_in(topo, (OT_TimeInterval) {{ 115 }, { 135 }}, found, 4);
+        success = OT_CHECK(count == 3);
+    }
+    {
+        // a clip given a child stops being a leaf, and the child plays
+        IntervalOidId nested = topo->new_oid(topo);
+        topo->set_bounds(topo, nested, (OT_TimeInterval) {{ 1 }, { 2 }});
+        topo->add_sync(topo, clips[0], nested);
+        topo->reflatten(topo, NULL);
+        size_t count = topo->active_at(topo, (OT_seconds) { 101.5f }, found, 4);
+        success = OT_CHECK(count == 1 && found[0].oid.id == nested.id && found[0].local.t == 1.5f);
+        success = OT_CHECK(topo->active_at(topo, (OT_seconds) { 105 }, found, 4) == 0);
+    }
+    topo->deinit(topo);
 }
 
+#endif // TESTING
+
 #endif //OPENTIMELINE_IMPL
 
 
@@ -0,0 +1,902 @@
+// cc opentimeline_bench.c thmap/src/thmap.c thmap/src/murmurhash.c
+//    -Ithmap/src -std=c11 -O2 -D_DEFAULT_SOURCE -o ot_bench
+//
+// usage: ot_bench [--sizes 1024,65536] [--min-time ms] [--filter name] [--csv | --json]
+//
+// Every benchmark is run at each size and repeated until it has been timed
+// for at least min-time. Results report ns/op, throughput, and calls into
+// the instrumented allocators per op. Only the timed region is counted.
+
+#include "opentimeline.h"
+
+#define RATIONAL32_NO_TESTS
+#include "rational_time.c"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "thmap.h"
+
+typedef enum { BenchText, BenchCSV, BenchJSON } BenchFormat;
+
+static struct {
+    size_t sizes[16];
+    int size_count;
+    double min_time_ns;
+    const char* filter;
+    BenchFormat format;
+} bench_opts = { { 1024, 65536 }, 2, 2e8, NULL, BenchText };
+
+// keeps the optimizer from discarding the results
+static volatile float bench_sink;
+static volatile intptr_t bench_isink;
+
+static size_t bench_alloc_count;
+
+static void* bench_malloc(size_t sz)
+{
+    ++bench_alloc_count;
+    return malloc(sz);
+}
+
+static void bench_free(void* p)
+{
+    free(p);
+}
+
+static uintptr_t bench_thmap_alloc(size_t sz)
+{
+    return (uintptr_t) bench_malloc(sz);
+}
+
+static void bench_thmap_free(uintptr_t p, size_t sz)
+{
+    (void) sz;
+    bench_free((void*) p);
+}
+
+static double bench_now_ns(void)
+{
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double) ts.tv_sec * 1e9 + (double) ts.tv_nsec;
+}
+
+typedef struct {
+    double elapsed_ns;
+    double ops;
+    size_t allocs;
+    double t0;
+    size_t allocs0;
+} BenchTimer;
+
+static void bench_start(BenchTimer* b)
+{
+    b->allocs0 = bench_alloc_count;
+    b->t0 = bench_now_ns();
+}
+
+static void bench_stop(BenchTimer* b, size_t ops)
+{
+    b->elapsed_ns += bench_now_ns() - b->t0;
+    b->allocs += bench_alloc_count - b->allocs0;
+    b->ops += (double) ops;
+}
+
+static bool bench_more(BenchTimer* b)
+{
+    return b->elapsed_ns < bench_opts.min_time_ns;
+}
+
+static bool bench_enabled(const char* name)
+{
+    return !bench_opts.filter || strstr(name, bench_opts.filter);
+}
+
+static void bench_report(const char* name, size_t n, BenchTimer* b)
+{
+    double ns_per_op = b->elapsed_ns / b->ops;
+    double mops = b->ops / b->elapsed_ns * 1e3;
+    double allocs = (double) b->allocs / b->ops;
+    switch (bench_opts.format) {
+        case BenchCSV:
+            printf("%s,%zu,%.0f,%.4f,%.3f,%.6f\n", name, n, b->ops, ns_per_op, mops, allocs);
+            break;
+        case BenchJSON:
+            printf("{\"name\":\"%s\",\"n\":%zu,\"ops\":%.0f,\"ns_per_op\":%.4f,"
+                   "\"mops_per_s\":%.3f,\"allocs_per_op\":%.6f}\n",
+                   name, n, b->ops, ns_per_op, mops, allocs);
+            break;
+        default:
+            printf("%-36s n=%-8zu %10.3f ns/op %10.2f Mop/s %10.4f allocs/op\n",
+                    name, n, ns_per_op, mops, allocs);
+            break;
+    }
+    fflush(stdout);
+}
+
+static uint32_t bench_rand_state = 12345;
+
+static uint32_t bench_rand(void)
+{
+    bench_rand_state = bench_rand_state * 1664525u + 1013904223u;
+    return bench_rand_state >> 8;
+}
+
+static float bench_randf(float lo, float hi)
+{
+    return lo + (hi - lo) * (float) (bench_rand() & 0xffff) / 65536.f;
+}
+
+//------- opentime
+
+static void bench_opentime(OpenTimeInterface* ot, size_t n)
+{
+    OT_TimeAffineTransform xform = { { 10.f }, 1.001f };
+    OT_seconds* in = (OT_seconds*) malloc(sizeof(OT_seconds) * n);
+    OT_seconds* out = (OT_seconds*) malloc(sizeof(OT_seconds) * n);
+    OT_TimeInterval* ivals = (OT_TimeInterval*) malloc(sizeof(OT_TimeInterval) * n);
+    OT_TimeInterval* ivals_b = (OT_TimeInterval*) malloc(sizeof(OT_TimeInterval) * n);
+    OT_TimeInterval* ivals_out = (OT_TimeInterval*) malloc(sizeof(OT_TimeInterval) * n);
+    uint8_t* relations = (uint8_t*) malloc(n);
+    for (size_t i = 0; i < n; ++i) {
+        in[i].t = (float) i / 48000.f;
+        float s = bench_randf(0.f, 100.f);
+        ivals[i] = (OT_TimeInterval) { { s }, { s + bench_randf(0.f, 10.f) } };
+        s = bench_randf(0.f, 100.f);
+        ivals_b[i] = (OT_TimeInterval) { { s }, { s + bench_randf(0.f, 10.f) } };
+    }
+
+    if (bench_enabled("transform_seconds.vtable")) {
+        BenchTimer b = { 0 };
+        while (bench_more(&b)) {
+            bench_start(&b);
+            for (size_t i = 0; i < n; ++i)
+                out[i] = ot->transform_seconds(&xform, &in[i]);
+            bench_stop(&b, n);
+        }
+        bench_sink = out[n - 1].t;
+        bench_report("transform_seconds.vtable", n, &b);
+    }
+    if (bench_enabled("transform_seconds.inline")) {
+        BenchTimer b = { 0 };
+        while (bench_more(&b)) {
+            bench_start(&b);
+            for (size_t i = 0; i < n; ++i)
+                out[i] = ot_inline_transform_seconds(xform, in[i]);
+            bench_stop(&b, n);
+        }
+        bench_sink = out[n - 1].t;
+        bench_report("transform_seconds.inline", n, &b);
+    }
+    if (bench_enabled("transform_seconds.batch")) {
+        BenchTimer b = { 0 };
+        while (bench_more(&b)) {
+            bench_start(&b);
+            ot->transform_seconds_n(&xform, in, out, n);
+            bench_stop(&b, n);
+        }
+        bench_sink = out[n - 1].t;
+        bench_report("transform_seconds.batch", n, &b);
+    }
+    if (bench_enabled("transform_interval.vtable")) {
+        BenchTimer b = { 0 };
+        while (bench_more(&b)) {
+            bench_start(&b);
+            for (size_t i = 0; i < n; ++i)
+                ivals_out[i] = ot->transform_interval(&xform, &ivals[i]);
+            bench_stop(&b, n);
+        }
+        bench_sink = ivals_out[n - 1].end.t;
+        bench_report("transform_interval.vtable", n, &b);
+    }
+    if (bench_enabled("transform_interval.batch")) {
+        BenchTimer b = { 0 };
+        while (bench_more(&b)) {
+            bench_start(&b);
+            ot->transform_interval_n(&xform, ivals, ivals_out, n);
+            bench_stop(&b, n);
+        }
+        bench_sink = ivals_out[n - 1].end.t;
+        bench_report("transform_interval.batch", n, &b);
+    }
+    if (bench_enabled("interval_relate.probe")) {
+        // what callers did before ot_interval_relate existed
+        BenchTimer b = { 0 };
+        while (bench_more(&b)) {
+            bench_start(&b);
+            for (size_t i = 0; i < n; ++i) {
+                OT_TimeInterval* x = &ivals[i];
+                OT_TimeInterval* y = &ivals_b[i];
+                relations[i] =
+                    ot->interval_equals(x, y) ? OT_AllenEquals :
+                    ot->interval_precedes(x, y) ? OT_AllenPrecedes :
+                    ot->interval_precedes(y, x) ? OT_AllenPrecededBy :
+                    ot->interval_meets(x, y) ? OT_AllenMeets :
+                    ot->interval_meets(y, x) ? OT_AllenMetBy :
+                    ot->interval_starts(x, y) ? OT_AllenStarts :
+                    ot->interval_starts(y, x) ? OT_AllenStartedBy :
+                    ot->interval_ends(x, y) ? OT_AllenFinishes :
+                    ot->interval_ends(y, x) ? OT_AllenFinishedBy :
+                    ot->interval_during(x, y) ? OT_AllenDuring :
+                    ot->interval_during(y, x) ? OT_AllenContains :
+                    ot->interval_overlaps(x, y) ? OT_AllenOverlaps :
+                    OT_AllenOverlappedBy;
+            }
+            bench_stop(&b, n);
+        }
+        bench_isink = relations[n - 1];
+        bench_report("interval_relate.probe", n, &b);
+    }
+    if (bench_enabled("interval_relate.batch")) {
+        BenchTimer b = { 0 };
+        while (bench_more(&b)) {
+            bench_start(&b);
+            ot->interval_relate_n(ivals, ivals_b, relations, n);
+            bench_stop(&b, n);
+        }
+        bench_isink = relations[n - 1];
+        bench_report("interval_relate.batch", n, &b);
+    }
+
+    free(in);
+    free(out);
+    free(ivals);
+    free(ivals_b);
+    free(ivals_out);
+    free(relations);
+}
+
+//------- curves
+
+// evaluations per timed round, independent of the knot count
+#define BENCH_CURVE_SAMPLES 4096
+
+static void bench_curves(CurveInterface* ci, size_t n)
+{
+    OT_ControlPoint* knots = (OT_ControlPoint*) malloc(sizeof(OT_ControlPoint) * n);
+    float v = 0.f;
+    for (size_t i = 0; i < n; ++i) {
+        knots[i] = (OT_ControlPoint) { { (float) i }, { v } };
+        v += bench_randf(0.5f, 1.5f);
+    }
+    TimeCurveLinear* tcl = ci->tcl_init_with_knots(ci, knots, (int) n);
+
+    float samples[BENCH_CURVE_SAMPLES];
+    for (int i = 0; i < BENCH_CURVE_SAMPLES; ++i)
+        samples[i] = bench_randf(0.f, (float) (n - 1));
+
+    if (bench_enabled("tcl_eval")) {
+        BenchTimer b = { 0 };
+        float acc = 0.f;
+        while (bench_more(&b)) {
+            bench_start(&b);
+            for (int i = 0; i < BENCH_CURVE_SAMPLES; ++i)
+                acc += ci->tcl_eval(ci, tcl, samples[i]).val;
+            bench_stop(&b, BENCH_CURVE_SAMPLES);
+        }
+        bench_sink = acc;
+        bench_report("tcl_eval", n, &b);
+    }
+    if (bench_enabled("tcc_eval")) {
+        TimeCurveCompiled* tcc = ci->tcc_compile(ci, tcl);
+        BenchTimer b = { 0 };
+        float acc = 0.f;
+        while (bench_more(&b)) {
+            bench_start(&b);
+            for (int i = 0; i < BENCH_CURVE_SAMPLES; ++i)
+                acc += ci->tcc_eval(ci, tcc, samples[i]).val;
+            bench_stop(&b, BENCH_CURVE_SAMPLES);
+        }
+        bench_sink = acc;
+        bench_report("tcc_eval", n, &b);
+        ci->tcc_deinit(ci, tcc);
+    }
+    if (bench_enabled("tcl_eval.nonuniform")) {
+        // tcl is on a uniform grid; the same knots jittered must search
+        OT_ControlPoint* jittered = (OT_ControlPoint*) malloc(sizeof(OT_ControlPoint) * n);
+        for (size_t i = 0; i < n; ++i) {
+            jittered[i] = knots[i];
+            if (i > 0 && i + 1 < n)
+                jittered[i].time.t += bench_randf(-0.25f, 0.25f);
+        }
+        TimeCurveLinear* searched = ci->tcl_init_with_knots(ci, jittered, (int) n);
+        BenchTimer b = { 0 };
+        float acc = 0.f;
+        while (bench_more(&b)) {
+            bench_start(&b);
+            for (int i = 0; i < BENCH_CURVE_SAMPLES; ++i)
+                acc += ci->tcl_eval(ci, searched, samples[i]).val;
+            bench_stop(&b, BENCH_CURVE_SAMPLES);
+        }
+        bench_sink = acc;
+        bench_report("tcl_eval.nonuniform", n, &b);
+        ci->tcl_deinit(ci, searched);
+        free(jittered);
+    }
+    if (bench_enabled("tcl_eval.cursor")) {
+        // playback: times advance through the whole curve
+        TimeCurveLinearCursor cursor = TimeCurveLinearCursor_default;
+        BenchTimer b = { 0 };
+        float acc = 0.f;
+        float step = (float) (n - 1) / (BENCH_CURVE_SAMPLES * 16);
+        float t = 0.f;
+        while (bench_more(&b)) {
+            bench_start(&b);
+            for (int i = 0; i < BENCH_CURVE_SAMPLES; ++i) {
+                acc += ci->tcl_eval_cursor(ci, tcl, &cursor, t).val;
+                t += step;
+                if (t >= (float) (n - 1))
+                    t = 0.f;
+            }
+            bench_stop(&b, BENCH_CURVE_SAMPLES);
+        }
+        bench_sink = acc;
+        bench_report("tcl_eval.cursor", n, &b);
+    }
+    if (bench_enabled("tcl_eval_many")) {
+        // the same sweep as tcl_eval.cursor, a block at a time
+        float times[BENCH_CURVE_SAMPLES];
+        float values[BENCH_CURVE_SAMPLES];
+        uint8_t oob[BENCH_CURVE_SAMPLES / 8];
+        BenchTimer b = { 0 };
+        float step = (float) (n - 1) / (BENCH_CURVE_SAMPLES * 16);
+        float t = 0.f;
+        while (bench_more(&b)) {
+            for (int i = 0; i < BENCH_CURVE_SAMPLES; ++i) {
+                times[i] = t;
+                t += step;
+                if (t >= (float) (n - 1))
+                    t = 0.f;
+            }
+            bench_start(&b);
+            ci->tcl_eval_many(ci, tcl, times, BENCH_CURVE_SAMPLES, values, oob);
+            bench_stop(&b, BENCH_CURVE_SAMPLES);
+        }
+        bench_sink = values[BENCH_CURVE_SAMPLES - 1];
+        bench_report("tcl_eval_many", n, &b);
+    }
+    if (bench_enabled("tcl_project_curve")) {
+        // a retime drifting forwards through tcl, with reversals
+        OT_ControlPoint* other_knots = (OT_ControlPoint*) malloc(sizeof(OT_ControlPoint) * n);
+        float drift = -1.f;
+        for (size_t i = 0; i < n; ++i) {
+            other_knots[i] = (OT_ControlPoint) { { (float) i }, { drift } };
+            drift += bench_randf(-1.f, 3.f);
+        }
+        TimeCurveLinear* other = ci->tcl_init_with_knots(ci, other_knots, (int) n);
+        BenchTimer b = { 0 };
+        while (bench_more(&b)) {
+            bench_start(&b);
+            TimeCurveLinearArray result = ci->tcl_project_curve(ci, tcl, other);
+            bench_stop(&b, n);
+            bench_sink = (float) result.count;
+            ci->tcl_array_deinit(ci, &result);
+        }
+        bench_report("tcl_project_curve", n, &b);
+        ci->tcl_deinit(ci, other);
+        free(other_knots);
+    }
+    if (bench_enabled("tcl_project_curve.affine")) {
+        // the common case: tcl through a two knot speed change
+        OT_ControlPoint line_knots[2] = { { { -1.f }, { 0.f } }, { { v + 1.f }, { 2.f * v } } };
+        TimeCurveLinear* line = ci->tcl_init_with_knots(ci, line_knots, 2);
+        BenchTimer b = { 0 };
+        while (bench_more(&b)) {
+            bench_start(&b);
+            TimeCurveLinearArray result = ci->tcl_project_curve(ci, line, tcl);
+            bench_stop(&b, n);
+            bench_sink = (float) result.count;
+            ci->tcl_array_deinit(ci, &result);
+        }
+        bench_report("tcl_project_curve.affine", n, &b);
+        ci->tcl_deinit(ci, line);
+    }
+    if (bench_enabled("tcl_inverse_eval")) {
+        // a retime that mostly plays forwards, with occasional rewinds
+        OT_ControlPoint* wander_knots = (OT_ControlPoint*) malloc(sizeof(OT_ControlPoint) * n);
+        float drift = 0.f;
+        for (size_t i = 0; i < n; ++i) {
+            wander_knots[i] = (OT_ControlPoint) { { (float) i }, { drift } };
+            drift += bench_randf(-1.f, 3.f);
+        }
+        TimeCurveLinear* wander = ci->tcl_init_with_knots(ci, wander_knots, (int) n);
+        TimeCurveInverse* inv = ci->tcl_inverse_build(ci, wander);
+        float times[64];
+        float hits = 0.f;
+
+        BenchTimer b = { 0 };
+        while (bench_more(&b)) {
+            bench_start(&b);
+            for (int i = 0; i < BENCH_CURVE_SAMPLES; ++i)
+                hits += (float) ci->tcl_inverse_eval(inv, samples[i], times, 64);
+            bench_stop(&b, BENCH_CURVE_SAMPLES);
+        }
+        bench_report("tcl_inverse_eval", n, &b);
+
+        // the scan it replaces
+        BenchTimer scan = { 0 };
+        while (bench_more(&scan)) {
+            bench_start(&scan);
+            for (int i = 0; i < BENCH_CURVE_SAMPLES / 64; ++i) {
+                float value = samples[i];
+                for (size_t k = 0; k + 1 < n; ++k) {
+                    float a = wander_knots[k].value.t;
+                    float c = wander_knots[k + 1].value.t;
+                    if ((value - a) * (value - c) <= 0.f)
+                        hits += 1.f;
+                }
+            }
+            bench_stop(&scan, BENCH_CURVE_SAMPLES / 64);
+        }
+        bench_report("tcl_inverse_eval.scan", n, &scan);
+        bench_sink = hits;
+
+        ci->tcl_inverse_deinit(ci, inv);
+        ci->tcl_deinit(ci, wander);
+        free(wander_knots);
+    }
+    if (bench_enabled("tcl_simplify")) {
+        // tcl has one knot per unit with jittered speed, like captured ramps
+        BenchTimer b = { 0 };
+        float err = 0.f;
+        size_t kept = 0;
+        while (bench_more(&b)) {
+            bench_start(&b);
+            TimeCurveLinear* simple = ci->tcl_simplify(ci, tcl, 0.25f, &err);
+            bench_stop(&b, n);
+            kept = cvector_size(simple->knots);
+            ci->tcl_deinit(ci, simple);
+        }
+        bench_sink = err + (float) kept;
+        bench_report("tcl_simplify", n, &b);
+    }
+    if (bench_enabled("tcl_extents")) {
+        BenchTimer b = { 0 };
+        float acc = 0.f;
+        while (bench_more(&b)) {
+            bench_start(&b);
+            for (int i = 0; i < BENCH_CURVE_SAMPLES; ++i) {
+                OT_CurveExtents e = ci->tcl_extents(tcl);
+                acc += e.max.value.t;
+            }
+            bench_stop(&b, BENCH_CURVE_SAMPLES);
+        }
+        bench_sink = acc;
+        bench_report("tcl_extents", n, &b);
+    }
+    if (bench_enabled("tcl_update_extents")) {
+        // the full rescan every tcl_extents call used to pay
+        BenchTimer b = { 0 };
+        while (bench_more(&b)) {
+            bench_start(&b);
+            ci->tcl_update_extents(tcl);
+            bench_stop(&b, 1);
+        }
+        bench_sink = tcl->extents.max.value.t;
+        bench_report("tcl_update_extents", n, &b);
+    }
+    if (bench_enabled("findU")) {
+        // one ease in/out segment across the sample range
+        float u[BENCH_CURVE_SAMPLES];
+        float p1 = 0.1f * (float) n;
+        float p2 = 0.9f * (float) n;
+        float p3 = (float) (n - 1);
+        BenchTimer b = { 0 };
+        while (bench_more(&b)) {
+            bench_start(&b);
+            for (int i = 0; i < BENCH_CURVE_SAMPLES; ++i)
+                u[i] = findU(samples[i], 0.f, p1, p2, p3);
+            bench_stop(&b, BENCH_CURVE_SAMPLES);
+        }
+        bench_sink = u[BENCH_CURVE_SAMPLES - 1];
+        bench_report("findU", n, &b);
+    }
+    if (bench_enabled("findU_n")) {
+        float u[BENCH_CURVE_SAMPLES];
+        OT_FindUTable table;
+        BenchTimer b = { 0 };
+        while (bench_more(&b)) {
+            bench_start(&b);
+            findU_table_init(&table, 0.f, 0.1f * (float) n, 0.9f * (float) n, (float) (n - 1));
+            findU_n(&table, samples, u, BENCH_CURVE_SAMPLES);
+            bench_stop(&b, BENCH_CURVE_SAMPLES);
+        }
+        bench_sink = u[BENCH_CURVE_SAMPLES - 1];
+        bench_report("findU_n", n, &b);
+    }
+    if (bench_enabled("tcb_eval")) {
+        // n unit segments easing through the same values as tcl
+        TimeCurveBezierSegment* segments = (TimeCurveBezierSegment*) 
+            malloc(sizeof(TimeCurveBezierSegment) * n);
+        for (size_t i = 0; i + 1 < n; ++i) {
+            float t = (float) i;
+            float v0 = knots[i].value.t;
+            float v1 = knots[i + 1].value.t;
+            segments[i] = (TimeCurveBezierSegment) { {
+                { { t }, { v0 } }, { { t + 0.3f }, { v0 } },
+                { { t + 0.7f }, { v1 } }, { { t + 1.f }, { v1 } } } };
+        }
+        TimeCurveBezier* tcb = ci->tcb_init_with_segments(ci, segments, (int) n - 1);
+        BenchTimer b = { 0 };
+        float acc = 0.f;
+        while (bench_more(&b)) {
+            bench_start(&b);
+            for (int i = 0; i < BENCH_CURVE_SAMPLES; ++i)
+                acc += ci->tcb_eval(ci, tcb, samples[i]).val;
+            bench_stop(&b, BENCH_CURVE_SAMPLES);
+        }
+        bench_sink = acc;
+        bench_report("tcb_eval", n, &b);
+
+        // playback from the cached linearization
+        TimeCurveLinear* linear = ci->tcb_linearize(ci, tcb, 1e-2f);
+        BenchTimer lb = { 0 };
+        while (bench_more(&lb)) {
+            bench_start(&lb);
+            for (int i = 0; i < BENCH_CURVE_SAMPLES; ++i)
+                acc += ci->tcl_eval(ci, linear, samples[i]).val;
+            bench_stop(&lb, BENCH_CURVE_SAMPLES);
+        }
+        bench_sink = acc;
+        bench_report("tcb_eval.linearized", n, &lb);
+        ci->tcb_deinit(ci, tcb);
+        free(segments);
+    }
+    if (bench_enabled("tcl_pyramid_query")) {
+        // one screen width over the whole curve
+        enum { pixels = 1920 };
+        float mn[pixels];
+        float mx[pixels];
+        float t1 = knots[n - 1].time.t;
+        TimeCurvePyramid* pyr = ci->tcl_pyramid_build(ci, tcl);
+        BenchTimer b = { 0 };
+        while (bench_more(&b)) {
+            bench_start(&b);
+            ci->tcl_pyramid_query(pyr, 0.f, t1, pixels, mn, mx);
+            bench_stop(&b, pixels);
+        }
+        bench_sink = mn[pixels - 1] + mx[0];
+        bench_report("tcl_pyramid_query", n, &b);
+
+        // the walk over every knot it replaces
+        BenchTimer scan = { 0 };
+        while (bench_more(&scan)) {
+            bench_start(&scan);
+            float w = t1 / (float) pixels;
+            size_t k = 0;
+            for (int p = 0; p < pixels; ++p) {
+                float lo = INFINITY;
+                float hi = -INFINITY;
+                float end = w * (float) (p + 1);
+                for (; k < n && knots[k].time.t < end; ++k) {
+                    lo = fminf(lo, knots[k].value.t);
+                    hi = fmaxf(hi, knots[k].value.t);
+                }
+                mn[p] = lo;
+                mx[p] = hi;
+            }
+            bench_stop(&scan, pixels);
+        }
+        bench_sink = mn[pixels - 1] + mx[0];
+        bench_report("tcl_pyramid_query.scan", n, &scan);
+
+        BenchTimer update = { 0 };
+        int i = 0;
+        while (bench_more(&update)) {
+            bench_start(&update);
+            for (int j = 0; j < 64; ++j) {
+                i = (i + 7919) % (int) n;
+                ci->tcl_pyramid_update(ci, pyr, i, i);
+            }
+            bench_stop(&update, 64);
+        }
+        bench_report("tcl_pyramid_update", n, &update);
+        ci->tcl_pyramid_deinit(ci, pyr);
+    }
+    if (bench_enabled("tcl_nearest_smaller_knot_index")) {
+        BenchTimer b = { 0 };
+        intptr_t acc = 0;
+        while (bench_more(&b)) {
+            bench_start(&b);
+            for (int i = 0; i < BENCH_CURVE_SAMPLES; ++i)
+                acc += ci->tcl_nearest_smaller_knot_index(tcl, samples[i]);
+            bench_stop(&b, BENCH_CURVE_SAMPLES);
+        }
+        bench_isink = acc;
+        bench_report("tcl_nearest_smaller_knot_index", n, &b);
+    }
+
+    ci->tcl_deinit(ci, tcl);
+    free(knots);
+}
+
+//------- topology
+
+static void bench_topology(TimelineAllocator* alloc, size_t n)
+{
+    IntervalOidId* ids = (IntervalOidId*) malloc(sizeof(IntervalOidId) * n);
+    if (bench_enabled("topo_add_seqs")) {
+        BenchTimer b = { 0 };
+        while (bench_more(&b)) {
+            bench_start(&b);
+            TimelineTopologyInterface* topo = timeline_topology_create((int) n + 1, alloc);
+            for (size_t i = 0; i < n; ++i)
+                ids[i] = topo->new_oid(topo);
+            topo->add_seqs(topo, topo->timeline_root.self, &ids[0], &ids[n]);
+            topo->deinit(topo);
+            bench_stop(&b, n);
+        }
+        bench_report("topo_add_seqs", n, &b);
+    }
+    if (bench_enabled("topo_new_oid.grow")) {
+        // no capacity up front; every page is added on demand
+        BenchTimer b = { 0 };
+        while (bench_more(&b)) {
+            bench_start(&b);
+            TimelineTopologyInterface* topo = timeline_topology_create(1, alloc);
+            for (size_t i = 0; i < n; ++i)
+                ids[i] = topo->new_oid(topo);
+            topo->deinit(topo);
+            bench_stop(&b, n);
+        }
+        bench_isink = ids[n - 1].id;
+        bench_report("topo_new_oid.grow", n, &b);
+    }
+    if (bench_enabled("topo_delete_new_oid")) {
+        // churn: delete a clip and take a new one, as an editing session does
+        TimelineTopologyInterface* topo = timeline_topology_create((int) n + 1, alloc);
+        for (size_t i = 0; i < n; ++i)
+            ids[i] = topo->new_oid(topo);
+        BenchTimer b = { 0 };
+        size_t k = 0;
+        while (bench_more(&b)) {
+            bench_start(&b);
+            for (int j = 0; j < 256; ++j) {
+                k = (k + 7919) % n;
+                topo->delete_oid(topo, ids[k]);
+                ids[k] = topo->new_oid(topo);
+            }
+            bench_stop(&b, 256);
+        }
+        bench_isink = ids[k].id;
+        bench_report("topo_delete_new_oid", n, &b);
+        topo->deinit(topo);
+    }
+    if (bench_enabled("topo_flatten")) {
+        // tracks of 1000 clips stacked under the root
+        TimelineTopologyInterface* topo = timeline_topology_create((int) n + 1, alloc);
+        for (size_t i = 0; i < n; ++i) {
+            ids[i] = topo->new_oid(topo);
+            IntervalOid* oid = topo->get_oid(topo, ids[i]);
+            oid->bounds = (OT_TimeInterval) {{ 0 }, { bench_randf(1.f, 10.f) }};
+        }
+        IntervalOidId parent = topo->timeline_root.self;
+        for (size_t first = 0; first < n; first += 1000) {
+            size_t last = first + 1000 < n ? first + 1000 : n;
+            IntervalOidId track = topo->new_oid(topo);
+            topo->add_sync(topo, parent, track);
+            topo->add_seqs(topo, track, &ids[first], &ids[last]);
+            parent = track;
+        }
+        BenchTimer b = { 0 };
+        while (bench_more(&b)) {
+            bench_start(&b);
+            const TimelineFlatCache* flat = topo->flatten(topo);
+            bench_stop(&b, n);
+            bench_sink = flat->bounds[flat->count - 2].end.t;
+        }
+        bench_report("topo_flatten", n, &b);
+
+        // one clip nudged per pass; the rest of its track moves with it
+        BenchTimer re = { 0 };
+        size_t k = 0;
+        while (bench_more(&re)) {
+            bench_start(&re);
+            for (int j = 0; j < 16; ++j) {
+                k = (k + 7919) % n;
+                OT_TimeInterval bounds = {{ 0 }, { bench_randf(1.f, 10.f) }};
+                topo->set_bounds(topo, ids[k], bounds);
+                OT_TimeInterval changed;
+                const TimelineFlatCache* flat = topo->reflatten(topo, &changed);
+                bench_isink = flat->changed_count;
+            }
+            bench_stop(&re, 16);
+        }
+        bench_report("topo_reflatten", n, &re);
+
+        // what plays at a time, from the index and by scanning the cache
+        const TimelineFlatCache* flat = topo->flatten(topo);
+        topo->build_active_index(topo);
+        float end = 0.f;
+        for (size_t i = 0; i < n; ++i)
+            end = fmaxf(end, flat->bounds[OT_OID_INDEX(ids[i].id)].end.t);
+        TimelineActiveClip found[64];
+        BenchTimer at = { 0 };
+        while (bench_more(&at)) {
+            bench_start(&at);
+            for (int j = 0; j < 256; ++j)
+                bench_isink = topo->active_at(topo, 
+                        (OT_seconds) { bench_randf(0.f, end) }, found, 64);
+            bench_stop(&at, 256);
+        }
+        bench_report("topo_active_at", n, &at);
+
+        BenchTimer scan = { 0 };
+        while (bench_more(&scan)) {
+            bench_start(&scan);
+            for (int j = 0; j < 16; ++j) {
+                float t = bench_randf(0.f, end);
+                size_t count = 0;
+                for (size_t i = 0; i < n; ++i) {
+                    OT_TimeInterval b = flat->bounds[OT_OID_INDEX(ids[i].id)];
+                    count += b.start.t <= t && t < b.end.t;
+                }
+                bench_isink = count;
+            }
+            bench_stop(&scan, 16);
+        }
+        bench_report("topo_active_at.scan", n, &scan);
+        topo->deinit(topo);
+    }
+    free(ids);
+}
+
+//------- rational
+
+static void bench_rational(size_t n)
+{
+    static const uint32_t dens[] = { 1, 24, 25, 30, 48, 1001, 24000, 30000, 48000 };
+    Rational32* a = (Rational32*) malloc(sizeof(Rational32) * n);
+    Rational32* r = (Rational32*) malloc(sizeof(Rational32) * n);
+    for (size_t i = 0; i < n; ++i) {
+        a[i] = (Rational32) { (int32_t) (bench_rand() % 20000) - 10000, dens[bench_rand() % 9] };
+        r[i] = (Rational32) { (int32_t) (bench_rand() % 20000) - 10000, dens[bench_rand() % 9] };
+    }
+
+    if (bench_enabled("rational32_add")) {
+        BenchTimer b = { 0 };
+        int32_t acc = 0;
+        while (bench_more(&b)) {
+            bench_start(&b);
+            for (size_t i = 0; i < n; ++i)
+                acc += rational32_add(a[i], r[i]).num;
+            bench_stop(&b, n);
+        }
+        bench_isink = acc;
+        bench_report("rational32_add", n, &b);
+    }
+    if (bench_enabled("rational32_mul")) {
+        BenchTimer b = { 0 };
+        int32_t acc = 0;
+        while (bench_more(&b)) {
+            bench_start(&b);
+            for (size_t i = 0; i < n; ++i)
+                acc += rational32_mul(a[i], r[i]).num;
+            bench_stop(&b, n);
+        }
+        bench_isink = acc;
+        bench_report("rational32_mul", n, &b);
+    }
+    if (bench_enabled("rational32_less_than")) {
+        BenchTimer b = { 0 };
+        int32_t acc = 0;
+        while (bench_more(&b)) {
+            bench_start(&b);
+            for (size_t i = 0; i < n; ++i)
+                acc += rational32_less_than(a[i], r[i]);
+            bench_stop(&b, n);
+        }
+        bench_isink = acc;
+        bench_report("rational32_less_than", n, &b);
+    }
+
+    free(a);
+    free(r);
+}
+
+//------- thmap
+
+static void bench_thmap(size_t n)
+{
+    static const thmap_ops_t ops = { bench_thmap_alloc, bench_thmap_free };
+    uint64_t* keys = (uint64_t*) malloc(sizeof(uint64_t) * n);
+    for (size_t i = 0; i < n; ++i)
+        keys[i] = ((uint64_t) bench_rand() << 32) ^ bench_rand() ^ i;
+
+    if (bench_enabled("thmap_put")) {
+        BenchTimer b = { 0 };
+        while (bench_more(&b)) {
+            thmap_t* map = thmap_create(0, &ops, 0);
+            bench_start(&b);
+            for (size_t i = 0; i < n; ++i)
+                thmap_put(map, &keys[i], sizeof(uint64_t), (void*) (uintptr_t) (i + 1));
+            bench_stop(&b, n);
+            for (size_t i = 0; i < n; ++i)
+                thmap_del(map, &keys[i], sizeof(uint64_t));
+            thmap_gc(map, thmap_stage_gc(map));
+            thmap_destroy(map);
+        }
+        bench_report("thmap_put", n, &b);
+    }
+    if (bench_enabled("thmap_get")) {
+        thmap_t* map = thmap_create(0, &ops, 0);
+        for (size_t i = 0; i < n; ++i)
+            thmap_put(map, &keys[i], sizeof(uint64_t), (void*) (uintptr_t) (i + 1));
+        BenchTimer b = { 0 };
+        uintptr_t acc = 0;
+        while (bench_more(&b)) {
+            bench_start(&b);
+            for (size_t i = 0; i < n; ++i)
+                acc += (uintptr_t) thmap_get(map, &keys[i], sizeof(uint64_t));
+            bench_stop(&b, n);
+        }
+        bench_isink = (intptr_t) acc;
+        bench_report("thmap_get", n, &b);
+        for (size_t i = 0; i < n; ++i)
+            thmap_del(map, &keys[i], sizeof(uint64_t));
+        thmap_gc(map, thmap_stage_gc(map));
+        thmap_destroy(map);
+    }
+
+    free(keys);
+}
+
+static void bench_usage(const char* argv0)
+{
+    fprintf(stderr, "usage: %s [--sizes n,n,...] [--min-time ms] "
+            "[--filter name] [--csv | --json]\n", argv0);
+}
+
+int main(int argc, char** argv)
+{
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "--csv"))
+            bench_opts.format = BenchCSV;
+        else if (!strcmp(argv[i], "--json"))
+            bench_opts.format = BenchJSON;
+        else if (!strcmp(argv[i], "--min-time") && i + 1 < argc)
+            bench_opts.min_time_ns = atof(argv[++i]) * 1e6;
+        else if (!strcmp(argv[i], "--filter") && i + 1 < argc)
+            bench_opts.filter = argv[++i];
+        else if (!strcmp(argv[i], "--sizes") && i + 1 < argc) {
+            bench_opts.size_count = 0;
+            for (char* s = argv[++i]; *s && bench_opts.size_count < 16; ) {
+                size_t n = strtoul(s, &s, 10);
+                if (n > 0)
+                    bench_opts.sizes[bench_opts.size_count++] = n;
+                if (*s == ',')
+                    ++s;
+                else
+                    break;
+            }
+        }
+        else {
+            bench_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (bench_opts.format == BenchCSV)
+        printf("name,n,ops,ns_per_op,mops_per_s,allocs_per_op\n");
+
+    OpenTimeAllocator ot_alloc = { .malloc = bench_malloc, .free = bench_free };
+    CurveAllocator curve_alloc = { .malloc = bench_malloc, .free = bench_free };
+    TimelineAllocator topo_alloc = { .malloc = bench_malloc, .free = bench_free };
+    OpenTimeInterface* ot = opentime_create(&ot_alloc);
+    CurveInterface* ci = curve_interface_create(&curve_alloc);
+
+    for (int s = 0; s < bench_opts.size_count; ++s) {
+        size_t n = bench_opts.sizes[s];
+        bench_opentime(ot, n);
+        bench_curves(ci, n);
+        bench_topology(&topo_alloc, n);
+        bench_rational(n);
+        bench_thmap(n);
+    }
+
+    ci->deinit(ci);
+    ot->deinit(ot);
+    return 0;
+}
@@ -12,10 +12,13 @@
  * A denominator of zero indicates infinity
  */
 
+#ifndef RATIONAL32_DEFINED
+#define RATIONAL32_DEFINED
 typedef struct {
     int32_t num;
     uint32_t den;
 } Rational32;
+#endif
 
 /*
  * TimeInterval32
@@ -437,6 +440,8 @@ int32_t tinterval32_rate_frames(TimeInterval32 a)
 }
 
 
+#ifndef RATIONAL32_NO_TESTS
+
 #include <stdio.h>
 #include "munit.h"
 #include "munit.c"
@@ -558,3 +563,4 @@ int main()
     return 0;
 }
 
+#endif // RATIONAL32_NO_TESTS